@@ -0,0 +1,130 @@
+// Heap allocations of the two DOT ASTs.
+//
+// Counts the calls to the global operator new made while parsing a
+// generated xdot document with DotParser::parse() and with parse_arena(),
+// and the calls to operator delete while the result is destroyed, along
+// with the time each step takes.
+//
+// Usage: xdot_arena_alloc_bench [megabytes]
+
+#include "xdot_cpp/dot/arena_ast.h"
+#include "xdot_cpp/dot/parser.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <string>
+
+namespace {
+
+std::atomic<size_t> allocations(0);
+std::atomic<size_t> deallocations(0);
+
+} // namespace
+
+void* operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    if (p) {
+        deallocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    operator delete(p);
+}
+
+// std::pmr::new_delete_resource(), and so the arena, allocates its blocks
+// with these
+void* operator new(size_t size, std::align_val_t alignment) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    size_t align = static_cast<size_t>(alignment);
+    if (void* p = std::aligned_alloc(align, (size + align - 1) / align * align)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+    operator delete(p);
+}
+
+void operator delete(void* p, size_t, std::align_val_t) noexcept {
+    operator delete(p);
+}
+
+using namespace xdot_cpp;
+
+namespace {
+
+// Laid out like dot -Txdot output: positioned nodes and spline edges with
+// drawing attributes
+std::string make_document(size_t bytes) {
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<int> coordinate(0, 20000);
+    auto point = [&] { return std::to_string(coordinate(rng)) + "." + std::to_string(rng() % 100); };
+    const size_t nodes = bytes / 400;
+
+    std::string text = "digraph G {\n  graph [bb=\"0,0,20000,20000\"];\n  node [label=\"\\N\", shape=ellipse];\n";
+    for (size_t i = 0; text.size() < bytes; i++) {
+        if (i < nodes) {
+            std::string x = point(), y = point();
+            text += "  n" + std::to_string(i) + " [height=0.5, pos=\"" + x + "," + y +
+                    "\", width=0.75, _draw_=\"c 7 -#000000 e " + x + " " + y + " 27 18 \", _ldraw_=\"F 14 11 "
+                    "-Times-Roman c 7 -#000000 T " + x + " " + y + " 0 15 2 -n" + std::to_string(i) + " \"];\n";
+        } else {
+            std::string curve;
+            for (int k = 0; k < 4; k++) {
+                curve += " " + point() + " " + point();
+            }
+            text += "  n" + std::to_string(rng() % nodes) + " -> n" + std::to_string(rng() % nodes) +
+                    " [pos=\"e," + point() + "," + point() + "\", _draw_=\"c 7 -#000000 B 4" + curve +
+                    " \", _hdraw_=\"S 5 -solid c 7 -#000000 C 7 -#000000 P 3 " + point() + " " + point() + " " +
+                    point() + " " + point() + " " + point() + " " + point() + " \"];\n";
+        }
+    }
+    return text + "}\n";
+}
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+template <typename Parse>
+void measure(const char* name, Parse parse) {
+    size_t before = allocations.load();
+    auto start = std::chrono::steady_clock::now();
+    auto graph = parse();
+    double parse_time = seconds_since(start);
+    size_t parse_allocations = allocations.load() - before;
+
+    before = deallocations.load();
+    start = std::chrono::steady_clock::now();
+    graph.reset();
+    double free_time = seconds_since(start);
+    size_t frees = deallocations.load() - before;
+
+    std::printf("%-20s %12zu allocations %8.3f s   %12zu frees %8.3f s\n", name, parse_allocations, parse_time,
+                frees, free_time);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t megabytes = argc > 1 ? static_cast<size_t>(std::atoi(argv[1])) : 48;
+    const std::string text = make_document(megabytes * 1024 * 1024);
+    std::printf("%.1f MB document\n", text.size() / (1024.0 * 1024.0));
+
+    measure("DotParser::parse()", [&] { return dot::DotParser(text).parse(); });
+    measure("parse_arena()", [&] { return dot::parse_arena(text); });
+    return 0;
+}
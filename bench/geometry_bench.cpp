@@ -0,0 +1,218 @@
+// Memory and hit-test throughput of the geometry storage precision.
+//
+// Builds the scene of a synthetic grid graph (box and ellipse nodes joined
+// by Bezier edges with arrowheads), then reports the memory its shapes
+// take, point and box hit tests per second through GraphElement, and the
+// throughput of the batch geometry kernels on their own. The precision is
+// fixed at build time; compare a default build with one configured with
+// -DXDOT_CPP_FLOAT_GEOMETRY=ON.
+//
+// Usage: xdot_geometry_bench [nodes] [queries]
+
+#include "xdot_cpp/xdot/geometry.h"
+#include "xdot_cpp/xdot/graph.h"
+#include "xdot_cpp/xdot/xdot_parser.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+using namespace xdot_cpp;
+
+namespace {
+
+const double SPACING = 120.0;
+
+std::string format(const char* spec, double value) {
+    char number[32];
+    std::snprintf(number, sizeof(number), spec, value);
+    return number;
+}
+
+std::string coordinates(const std::vector<double>& values) {
+    std::string text;
+    for (double value : values) {
+        text += format(" %.2f", value);
+    }
+    return text;
+}
+
+std::string node_statement(size_t id, double x, double y) {
+    std::string name = "n" + std::to_string(id);
+    std::string draw = "c 7 -#000000 ";
+    if (id % 2) {
+        draw += "e" + coordinates({x, y, 27, 18});
+    } else {
+        draw += "p 4" + coordinates({x + 27, y + 18, x - 27, y + 18, x - 27, y - 18, x + 27, y - 18});
+    }
+    return "  " + name + " [_draw_=\"" + draw + " \", _ldraw_=\"F 14 11 -Times-Roman c 7 -#000000 T" +
+           coordinates({x, y - 4}) + " 0 30 " + std::to_string(name.size()) + " -" + name + " \"];\n";
+}
+
+// A wavy spline from (x1, y1) to (x2, y2) and its arrowhead
+std::string edge_statement(size_t from, size_t to, double x1, double y1, double x2, double y2,
+                           std::mt19937& rng) {
+    std::uniform_real_distribution<double> wobble(-20.0, 20.0);
+    const int segments = 3;
+    std::vector<double> points = {x1, y1};
+    for (int i = 1; i <= segments * 3; i++) {
+        double t = static_cast<double>(i) / (segments * 3);
+        bool end = i == segments * 3;
+        points.push_back(x1 + (x2 - x1) * t + (end ? 0 : wobble(rng)));
+        points.push_back(y1 + (y2 - y1) * t + (end ? 0 : wobble(rng)));
+    }
+    double dx = x2 - x1, dy = y2 - y1;
+    double length = std::sqrt(dx * dx + dy * dy);
+    dx /= length;
+    dy /= length;
+    std::vector<double> arrow = {x2 - 10 * dx - 4 * dy, y2 - 10 * dy + 4 * dx,
+                                 x2, y2,
+                                 x2 - 10 * dx + 4 * dy, y2 - 10 * dy - 4 * dx};
+    return "  n" + std::to_string(from) + " -> n" + std::to_string(to) +
+           " [_draw_=\"c 7 -#000000 B " + std::to_string(points.size() / 2) + coordinates(points) +
+           " \", _hdraw_=\"S 5 -solid c 7 -#000000 C 7 -#000000 P 3" + coordinates(arrow) + " \"];\n";
+}
+
+std::string make_graph(size_t nodes) {
+    std::mt19937 rng(11);
+    size_t columns = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(nodes))));
+    auto x_of = [&](size_t id) { return static_cast<double>(id % columns) * SPACING + 30.0; };
+    auto y_of = [&](size_t id) { return static_cast<double>(id / columns) * SPACING + 30.0; };
+
+    std::string text = "digraph G {\n";
+    for (size_t id = 0; id < nodes; id++) {
+        text += node_statement(id, x_of(id), y_of(id));
+    }
+    for (size_t id = 0; id < nodes; id++) {
+        if ((id + 1) % columns && id + 1 < nodes) {
+            text += edge_statement(id, id + 1, x_of(id) + 27, y_of(id), x_of(id + 1) - 27, y_of(id + 1), rng);
+        }
+        if (id + columns < nodes) {
+            text += edge_statement(id, id + columns, x_of(id), y_of(id) + 18,
+                                   x_of(id + columns), y_of(id + columns) - 18, rng);
+        }
+    }
+    return text + "}\n";
+}
+
+// Resident set size in bytes, or 0 where /proc is not available
+size_t resident_bytes() {
+    std::ifstream statm("/proc/self/statm");
+    size_t pages = 0, resident = 0;
+    if (!(statm >> pages >> resident)) {
+        return 0;
+    }
+    return resident * 4096;
+}
+
+// Elements share the display lists they were decoded into
+size_t shape_bytes(const xdot::GraphElement& graph) {
+    std::unordered_set<const xdot::DisplayList*> lists = {graph.display_list().get()};
+    for (const auto& node : graph.nodes()) lists.insert(&node->display_list());
+    for (const auto& edge : graph.edges()) lists.insert(&edge->display_list());
+    size_t bytes = 0;
+    for (const auto* list : lists) bytes += list->memory_usage();
+    return bytes;
+}
+
+template <typename Body>
+double seconds(Body body) {
+    auto start = std::chrono::steady_clock::now();
+    body();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t nodes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 40000;
+    size_t queries = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 200000;
+
+    std::printf("coordinates     %s (Point %zu bytes, BoundingBox %zu bytes), %s kernels\n",
+                sizeof(xdot::Coord) == sizeof(float) ? "float" : "double",
+                sizeof(xdot::Point), sizeof(xdot::BoundingBox), xdot::geometry::kernel_name());
+
+    std::string text = make_graph(nodes);
+    auto dot_graph = dot::DotParser(text).parse();
+    size_t resident_before = resident_bytes();
+    std::shared_ptr<xdot::GraphElement> graph;
+    double build = seconds([&] { graph = xdot::XDotParser(dot_graph).parse(); });
+
+    // Point queries: half on nodes, half anywhere in the graph
+    const xdot::BoundingBox bounds = graph->bounding_box();
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<double> x(bounds.x1, bounds.x2), y(bounds.y1, bounds.y2);
+    std::vector<xdot::Point> points;
+    for (size_t i = 0; i < queries; i++) {
+        if (i % 2) {
+            const auto& box = graph->nodes()[rng() % graph->nodes().size()]->bounding_box();
+            points.emplace_back((box.x1 + box.x2) / 2, (box.y1 + box.y2) / 2);
+        } else {
+            points.emplace_back(x(rng), y(rng));
+        }
+    }
+
+    size_t hits = 0;
+    graph->find_node_at(points[0]);  // builds the indexes
+    double point_time = seconds([&] {
+        for (const auto& p : points) {
+            hits += graph->find_node_at(p) != nullptr;
+            hits += graph->find_edge_at(p) != nullptr;
+        }
+    });
+
+    // Range queries the size of a zoomed-in view
+    size_t found = 0;
+    size_t ranges = queries / 100 + 1;
+    double range_time = seconds([&] {
+        for (size_t i = 0; i < ranges; i++) {
+            const auto& p = points[i];
+            xdot::BoundingBox area(p.x, p.y, p.x + 800, p.y + 600);
+            found += graph->find_nodes_in(area).size() + graph->find_edges_in(area).size();
+        }
+    });
+
+    size_t resident_after = resident_bytes();
+    size_t shapes = shape_bytes(*graph);
+    std::printf("scene           %zu nodes, %zu edges, built in %.3f s\n",
+                graph->nodes().size(), graph->edges().size(), build);
+    std::printf("shape memory    %8.1f MB\n", static_cast<double>(shapes) / 1e6);
+    if (resident_before && resident_after) {
+        std::printf("scene RSS       %8.1f MB  (shapes, indexes and flattened curves)\n",
+                    static_cast<double>(resident_after - resident_before) / 1e6);
+    }
+    std::printf("point hit test  %8.2f M queries/s  (%zu hits)\n",
+                static_cast<double>(points.size()) * 2 / point_time / 1e6, hits);
+    std::printf("range query     %8.1f k queries/s  (%zu results)\n",
+                static_cast<double>(ranges) * 2 / range_time / 1e3, found);
+
+    // Kernels alone, on a long polyline no query is near
+    std::vector<xdot::Point> polyline;
+    std::uniform_real_distribution<double> coordinate(0.0, 20000.0);
+    for (size_t i = 0; i < 4096; i++) {
+        polyline.emplace_back(coordinate(rng), coordinate(rng));
+    }
+    const xdot::Point far(-1000, -1000);
+    const int passes = 2000;
+    size_t near = 0;
+    double polyline_time = seconds([&] {
+        for (int i = 0; i < passes; i++) {
+            near += xdot::geometry::polyline_near(polyline.data(), polyline.size(), far, 2.0);
+        }
+    });
+    double contains_time = seconds([&] {
+        for (int i = 0; i < passes; i++) {
+            near += xdot::geometry::polygon_contains(polyline.data(), polyline.size(), far);
+        }
+    });
+    double work = static_cast<double>(polyline.size()) * passes;
+    std::printf("polyline_near   %8.1f M segments/s\n", work / polyline_time / 1e6);
+    std::printf("polygon_contains%8.1f M edges/s  (%zu)\n", work / contains_time / 1e6, near);
+    return 0;
+}
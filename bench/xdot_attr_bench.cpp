@@ -0,0 +1,127 @@
+// Decoding throughput of xdot drawing attributes.
+//
+// Reports coordinates decoded per second for the number reader on its own,
+// comparing the original std::string + std::stod reader with the
+// allocation-free one XDotAttrParser uses, and for XDotAttrParser::parse()
+// on typical edge and node drawing operations.
+//
+// Usage: xdot_attr_bench [iterations]
+
+#include "xdot_cpp/xdot/xdot_parser.h"
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+
+using namespace xdot_cpp;
+
+namespace {
+
+// Edge-like operations: a long Bezier spline, an arrowhead and a label
+std::string make_draw_attribute(std::mt19937& rng, int bezier_points) {
+    std::uniform_real_distribution<double> coordinate(-2000.0, 20000.0);
+    char number[32];
+    std::string draw = "c 7 -#000000 B " + std::to_string(bezier_points);
+    for (int i = 0; i < bezier_points * 2; i++) {
+        std::snprintf(number, sizeof(number), " %.2f", coordinate(rng));
+        draw += number;
+    }
+    draw += " C 7 -#000000 P 3";
+    for (int i = 0; i < 6; i++) {
+        std::snprintf(number, sizeof(number), " %.2f", coordinate(rng));
+        draw += number;
+    }
+    draw += " F 14 11 -Times-Roman T 12.5 -3.2 0 42.77 5 -label";
+    return draw;
+}
+
+// The reader XDotAttrParser used before switching to from_chars
+double legacy_read_float(const std::string& data, size_t& pos) {
+    while (pos < data.length() && std::isspace(static_cast<unsigned char>(data[pos]))) pos++;
+    std::string num_str;
+    bool negative = false;
+    if (pos < data.length() && data[pos] == '-') {
+        negative = true;
+        pos++;
+    }
+    while (pos < data.length() && (std::isdigit(static_cast<unsigned char>(data[pos])) || data[pos] == '.')) {
+        num_str += data[pos++];
+    }
+    if (num_str.empty()) return 0.0;
+    double result = std::stod(num_str);
+    return negative ? -result : result;
+}
+
+double fast_read_float(const std::string& data, size_t& pos) {
+    while (pos < data.length() && std::isspace(static_cast<unsigned char>(data[pos]))) pos++;
+    double value = 0.0;
+    auto result = std::from_chars(data.data() + pos, data.data() + data.length(), value);
+    pos = static_cast<size_t>(result.ptr - data.data());
+    return value;
+}
+
+template <typename Reader>
+double numbers_per_second(const std::string& numbers, size_t count, int iterations, Reader read) {
+    double checksum = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    for (int it = 0; it < iterations; it++) {
+        size_t pos = 0;
+        for (size_t i = 0; i < count; i++) {
+            checksum += read(numbers, pos);
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    if (checksum == 0.123) std::puts("");  // keep the loop alive
+    return static_cast<double>(count) * iterations / elapsed.count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 20;
+    std::mt19937 rng(7);
+
+    // Number reader alone
+    std::uniform_real_distribution<double> coordinate(-2000.0, 20000.0);
+    std::string numbers;
+    const size_t count = 1000000;
+    char number[32];
+    for (size_t i = 0; i < count; i++) {
+        std::snprintf(number, sizeof(number), " %.2f", coordinate(rng));
+        numbers += number;
+    }
+
+    double legacy = numbers_per_second(numbers, count, iterations, legacy_read_float);
+    double fast = numbers_per_second(numbers, count, iterations, fast_read_float);
+    std::printf("number reader   std::stod     %8.1f M coordinates/s\n", legacy / 1e6);
+    std::printf("number reader   from_chars    %8.1f M coordinates/s  (%.1fx)\n", fast / 1e6, fast / legacy);
+
+    // Whole attribute parser
+    std::vector<std::string> attributes;
+    size_t coordinates = 0;
+    for (int i = 0; i < 2000; i++) {
+        int points = 4 + 3 * static_cast<int>(rng() % 8);
+        attributes.push_back(make_draw_attribute(rng, points));
+        coordinates += static_cast<size_t>(points) * 2 + 6 + 2;
+    }
+
+    // One list per attribute, as for the elements of a lazily decoded graph
+    auto pens = std::make_shared<xdot::PenPool>();
+    auto prototypes = std::make_shared<xdot::PrototypePool>();
+    size_t shapes = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int it = 0; it < iterations; it++) {
+        for (const auto& attribute : attributes) {
+            xdot::DisplayList list(pens, prototypes);
+            xdot::XDotAttrParser parser(attribute);
+            shapes += parser.parse(list).size();
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::printf("XDotAttrParser  parse()       %8.1f M coordinates/s  (%zu shapes)\n",
+                static_cast<double>(coordinates) * iterations / elapsed.count() / 1e6, shapes);
+    return 0;
+}
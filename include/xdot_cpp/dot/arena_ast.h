@@ -0,0 +1,183 @@
+#pragma once
+
+#include "parser.h"
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace xdot_cpp {
+namespace dot {
+
+// Compact DOT AST for large graphs. Elements live in flat arrays and refer
+// to each other by index; every string is bump-allocated from one
+// per-parse monotonic arena. Nothing is individually heap allocated or
+// reference counted; building costs the arena blocks plus the growth of
+// the arrays, a number of allocations logarithmic in the graph size.
+// The AST holds everything dot::Graph does: statement order, and the
+// defaults in effect at each statement.
+
+// Index of a default set in ArenaGraph::default_sets, or none
+using DefaultSet = uint32_t;
+constexpr DefaultSet NO_DEFAULTS = UINT32_MAX;
+
+// [begin, begin + count) into one of the ArenaGraph arrays
+struct IndexRange {
+    uint32_t begin;
+    uint32_t count;
+
+    IndexRange(uint32_t b = 0, uint32_t c = 0) : begin(b), count(c) {}
+};
+
+struct ArenaAttribute {
+    std::string_view name;
+    std::string_view value;
+};
+
+// One node statement; repeated statements for an ID each get one
+struct ArenaNode {
+    std::string_view id;
+    IndexRange attributes;
+    DefaultSet defaults;
+    // Position among the node and edge statements of the document
+    uint32_t sequence;
+};
+
+struct ArenaEdge {
+    std::string_view source;
+    std::string_view target;
+    IndexRange attributes;
+    DefaultSet defaults;
+    // Node defaults in effect, for endpoints first mentioned here
+    DefaultSet node_defaults;
+    uint32_t sequence;
+};
+
+// Contents of a graph or subgraph body. Attribute ranges index
+// ArenaGraph::attributes; node, edge and subgraph ranges index
+// ArenaGraph::children, which in turn holds indices into the element arrays.
+struct ArenaScope {
+    IndexRange attributes;
+    // Defaults in effect at the end of the body, inherited ones included
+    DefaultSet node_defaults = NO_DEFAULTS;
+    DefaultSet edge_defaults = NO_DEFAULTS;
+    IndexRange nodes;
+    IndexRange edges;
+    IndexRange subgraphs;
+};
+
+struct ArenaSubgraph {
+    std::string_view id;
+    ArenaScope scope;
+};
+
+template <typename T>
+class ArenaSpan {
+public:
+    ArenaSpan(const T* data, size_t size) : data_(data), size_(size) {}
+
+    const T* begin() const { return data_; }
+    const T* end() const { return data_ + size_; }
+    const T& operator[](size_t i) const { return data_[i]; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+private:
+    const T* data_;
+    size_t size_;
+};
+
+class ArenaGraph {
+public:
+    ArenaGraph();
+
+    ArenaGraph(const ArenaGraph&) = delete;
+    ArenaGraph& operator=(const ArenaGraph&) = delete;
+
+    Graph::Type type;
+    bool strict;
+    std::string_view id;
+    ArenaScope root;
+
+    std::vector<ArenaNode> nodes;
+    std::vector<ArenaEdge> edges;
+    std::vector<ArenaSubgraph> subgraphs;
+    std::vector<ArenaAttribute> attributes;
+    std::vector<uint32_t> children;
+    // Attributes of node or edge default statements merged with the ones
+    // in effect before, one entry per name. Elements declared while a set
+    // is in effect share it.
+    std::vector<IndexRange> default_sets;
+
+    ArenaSpan<ArenaAttribute> attributes_of(const IndexRange& range) const {
+        return ArenaSpan<ArenaAttribute>(attributes.data() + range.begin, range.count);
+    }
+    ArenaSpan<uint32_t> children_of(const IndexRange& range) const {
+        return ArenaSpan<uint32_t>(children.data() + range.begin, range.count);
+    }
+    // Empty for NO_DEFAULTS
+    ArenaSpan<ArenaAttribute> defaults_of(DefaultSet set) const {
+        return set == NO_DEFAULTS ? ArenaSpan<ArenaAttribute>(nullptr, 0) : attributes_of(default_sets[set]);
+    }
+
+    // Copies text into the arena
+    std::string_view store(std::string_view text);
+    // Bytes of string data held by the arena
+    size_t arena_bytes() const { return arena_bytes_; }
+
+private:
+    std::pmr::monotonic_buffer_resource arena_;
+    size_t arena_bytes_;
+};
+
+// Builds an ArenaGraph from DotParser events
+class ArenaAstBuilder : public GraphBuilder {
+public:
+    ArenaAstBuilder();
+
+    std::shared_ptr<ArenaGraph> graph() const { return graph_; }
+
+    void begin_graph(Graph::Type type, bool strict, std::string_view id) override;
+    void end_graph() override;
+    void begin_subgraph(std::string_view id) override;
+    void end_subgraph() override;
+    void add_node(std::string_view id, const AttributeViews& attributes) override;
+    void add_edge(std::string_view source, std::string_view target,
+                  const AttributeViews& attributes) override;
+    void add_attributes(TokenType kind, const AttributeViews& attributes) override;
+
+private:
+    // Children of an open scope are collected here and copied into the
+    // graph arrays when it closes, so each scope ends up with contiguous
+    // ranges. Entries are reused across scopes at the same depth.
+    struct OpenScope {
+        std::vector<ArenaAttribute> attributes;
+        DefaultSet node_defaults;
+        DefaultSet edge_defaults;
+        std::vector<uint32_t> nodes;
+        std::vector<uint32_t> edges;
+        std::vector<uint32_t> subgraphs;
+    };
+
+    std::shared_ptr<ArenaGraph> graph_;
+    std::vector<OpenScope> scopes_;
+    size_t depth_;
+
+    void open_scope();
+    ArenaScope close_scope();
+    IndexRange store_attributes(const AttributeViews& attributes);
+    void append_attributes(std::vector<ArenaAttribute>& target, const AttributeViews& attributes);
+    DefaultSet merge_defaults(DefaultSet defaults, const AttributeViews& attributes);
+    uint32_t next_sequence() const;
+    IndexRange flush_attributes(const std::vector<ArenaAttribute>& source);
+    IndexRange flush_children(const std::vector<uint32_t>& source);
+};
+
+std::shared_ptr<ArenaGraph> parse_arena(const std::string& text);
+// Parses a caller-owned buffer; the result does not refer back to it
+std::shared_ptr<ArenaGraph> parse_arena(const char* data, size_t size);
+
+} // namespace dot
+} // namespace xdot_cpp
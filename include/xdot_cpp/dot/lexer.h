@@ -1,7 +1,9 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
+#include <deque>
 #include <stdexcept>
 
 namespace xdot_cpp {
@@ -34,19 +36,30 @@ enum class TokenType {
     SUBGRAPH = 18
 };
 
+// Token text is a view into the lexer's input buffer, or into lexer-owned
+// storage for quoted strings that needed unescaping. It stays valid for the
+// lifetime of the DotLexer that produced it. Positions are byte offsets;
+// DotLexer::location() turns them into line:column on demand.
 struct Token {
     TokenType type;
-    std::string text;
+    std::string_view text;
+    size_t offset;
+    
+    Token(TokenType t = TokenType::EOF_TOKEN, std::string_view txt = {}, size_t off = 0)
+        : type(t), text(txt), offset(off) {}
+};
+
+struct SourceLocation {
     size_t line;
     size_t column;
     
-    Token(TokenType t = TokenType::EOF_TOKEN, const std::string& txt = "", size_t l = 0, size_t c = 0)
-        : type(t), text(txt), line(l), column(c) {}
+    SourceLocation(size_t l = 0, size_t c = 0) : line(l), column(c) {}
 };
 
 class ParseError : public std::runtime_error {
 public:
     ParseError(const std::string& message, size_t line = 0, size_t column = 0);
+    ParseError(const std::string& message, const SourceLocation& location);
     
     size_t line() const { return line_; }
     size_t column() const { return column_; }
@@ -58,20 +71,32 @@ private:
 
 class DotLexer {
 public:
+    // Lexes a private copy of text.
     explicit DotLexer(const std::string& text);
+    // Lexes a caller-owned buffer (e.g. an mmap) without copying it. The
+    // buffer must outlive the lexer and every token it returns.
+    DotLexer(const char* data, size_t size);
+    
+    DotLexer(const DotLexer&) = delete;
+    DotLexer& operator=(const DotLexer&) = delete;
     
     Token next_token();
     Token peek_token();
     bool has_more() const;
     
-    size_t line() const { return line_; }
-    size_t column() const { return column_; }
+    size_t offset() const { return pos_; }
+    size_t line() const { return location(pos_).line; }
+    size_t column() const { return location(pos_).column; }
+    
+    // 1-based line and column of a byte offset into the input
+    SourceLocation location(size_t offset) const;
     
 private:
-    std::string text_;
+    std::string owned_text_;
+    std::string_view text_;
+    std::deque<std::string> unescaped_;
     size_t pos_;
-    size_t line_;
-    size_t column_;
+    mutable std::vector<size_t> line_starts_;
     Token peeked_token_;
     bool has_peeked_;
     
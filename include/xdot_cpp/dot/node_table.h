@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace xdot_cpp {
+namespace dot {
+
+// Position of a node in Graph::nodes
+using NodeIndex = uint32_t;
+
+constexpr NodeIndex NO_NODE = UINT32_MAX;
+
+// Maps node IDs to dense node indices. Open addressing with linear probing
+// over a power-of-two slot array; each slot keeps the ID hash so probes
+// only compare strings on a hash match. Keys are not copied; Graph uses
+// the Node::id strings, which stay put because nodes are heap allocated.
+class NodeTable {
+public:
+    NodeTable();
+
+    // NO_NODE if id is not in the table
+    NodeIndex find(std::string_view id) const { return find(id, hash(id)); }
+    // Index of id, adding it with the next free index if missing
+    NodeIndex insert(std::string_view id, bool* inserted = nullptr) {
+        return insert(id, hash(id), inserted);
+    }
+
+    // Variants taking a precomputed hash(id), so hashing can be done
+    // ahead of time on another thread
+    NodeIndex find(std::string_view id, uint32_t id_hash) const;
+    NodeIndex insert(std::string_view id, uint32_t id_hash, bool* inserted = nullptr);
+
+    static uint32_t hash(std::string_view id);
+
+    size_t size() const { return size_; }
+    void clear();
+
+private:
+    struct Slot {
+        std::string_view key;
+        uint32_t hash;
+        NodeIndex index;
+    };
+
+    std::vector<Slot> slots_;
+    size_t size_;
+
+    size_t probe(std::string_view id, uint32_t h) const;
+    void grow();
+};
+
+} // namespace dot
+} // namespace xdot_cpp
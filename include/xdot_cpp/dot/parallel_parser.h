@@ -0,0 +1,21 @@
+#pragma once
+
+#include "parser.h"
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace xdot_cpp {
+namespace dot {
+
+// Multi-threaded parse of a complete document into the same Graph that
+// DotParser::parse() builds. The body is cut into one slice per worker;
+// each worker finds the top-level statement boundaries in its slice and
+// parses its statements, and the results are merged in document order on
+// the calling thread. workers == 0 uses every hardware thread. Small inputs
+// are parsed on the calling thread alone.
+std::shared_ptr<Graph> parse_parallel(const std::string& text, size_t workers = 0);
+std::shared_ptr<Graph> parse_parallel(const char* data, size_t size, size_t workers = 0);
+
+} // namespace dot
+} // namespace xdot_cpp
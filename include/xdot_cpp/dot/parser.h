@@ -1,42 +1,121 @@
 #pragma once
 
 #include "lexer.h"
+#include "node_table.h"
+#include "symbol_table.h"
+#include <array>
 #include <memory>
 #include <map>
+#include <string_view>
+#include <unordered_set>
 #include <vector>
 
 namespace xdot_cpp {
 namespace dot {
 
+// Attribute of a parsed graph. The name is a symbol of the owning graph's
+// SymbolTable and the value points into that table's storage.
 struct Attribute {
-    std::string name;
-    std::string value;
+    Symbol name;
+    std::string_view value;
     
-    Attribute(const std::string& n = "", const std::string& v = "") : name(n), value(v) {}
+    Attribute(Symbol n = NO_SYMBOL, std::string_view v = {}) : name(n), value(v) {}
 };
 
-using AttributeList = std::vector<Attribute>;
+// Attributes in statement order, one entry per name (a later assignment
+// replaces the earlier value). Well-known symbols are found through a slot
+// table in O(1); other names fall back to a linear scan.
+class AttributeList {
+public:
+    using const_iterator = std::vector<Attribute>::const_iterator;
+    
+    AttributeList() { slots_.fill(NO_SLOT); }
+    
+    void set(Symbol name, std::string_view value);
+    void clear();
+    // Rewrites every attribute in place through rename(Attribute&), for
+    // moving the list to another symbol table. Well-known symbols are the
+    // same in every table and must be left alone.
+    template <typename Rename>
+    void remap(Rename rename) {
+        for (auto& attr : items_) rename(attr);
+    }
+    void reserve(size_t count) { items_.reserve(count); }
+    
+    // nullptr if name is not set
+    const Attribute* find(Symbol name) const;
+    std::string_view get(Symbol name, std::string_view default_value = {}) const;
+    bool has(Symbol name) const { return find(name) != nullptr; }
+    
+    const_iterator begin() const { return items_.begin(); }
+    const_iterator end() const { return items_.end(); }
+    const Attribute& operator[](size_t i) const { return items_[i]; }
+    size_t size() const { return items_.size(); }
+    bool empty() const { return items_.empty(); }
+    
+private:
+    static constexpr uint8_t NO_SLOT = 0xFF;
+    
+    std::vector<Attribute> items_;
+    // Index into items_ per well-known symbol
+    std::array<uint8_t, symbols::WELL_KNOWN_COUNT> slots_;
+};
 
+// Defaults set by node/edge attribute statements. Sets are immutable once
+// published and shared by every element declared while they are in effect;
+// a later statement publishes a new merged copy instead of modifying them.
+using AttributeSet = std::shared_ptr<const AttributeList>;
+
+// Looks name up in attributes, then in defaults
+inline std::string_view lookup_attribute(const AttributeList& attributes, const AttributeSet& defaults,
+                                         Symbol name, std::string_view default_value = {}) {
+    if (const Attribute* attr = attributes.find(name)) {
+        return attr->value;
+    }
+    return defaults ? defaults->get(name, default_value) : default_value;
+}
+
+// One per distinct node ID; repeated node statements merge their
+// attributes into it
 struct Node {
     std::string id;
     AttributeList attributes;
+    // Node defaults in effect where the node was first seen; may be null
+    AttributeSet defaults;
     
     explicit Node(const std::string& node_id = "") : id(node_id) {}
+    
+    std::string_view attribute(Symbol name, std::string_view default_value = {}) const {
+        return lookup_attribute(attributes, defaults, name, default_value);
+    }
 };
 
+// Position of an edge in Graph::edges
+using EdgeIndex = uint32_t;
+
 struct Edge {
-    std::string source;
-    std::string target;
+    NodeIndex source;
+    NodeIndex target;
     AttributeList attributes;
+    // Edge defaults in effect at the declaration; may be null
+    AttributeSet defaults;
+    
+    Edge(NodeIndex src = NO_NODE, NodeIndex tgt = NO_NODE) : source(src), target(tgt) {}
     
-    Edge(const std::string& src = "", const std::string& tgt = "") : source(src), target(tgt) {}
+    std::string_view attribute(Symbol name, std::string_view default_value = {}) const {
+        return lookup_attribute(attributes, defaults, name, default_value);
+    }
 };
 
 struct Subgraph {
     std::string id;
     AttributeList attributes;
-    std::vector<std::shared_ptr<Node>> nodes;
-    std::vector<std::shared_ptr<Edge>> edges;
+    // Defaults in effect at the end of the body, inherited ones included
+    AttributeSet node_defaults;
+    AttributeSet edge_defaults;
+    // Nodes and edges stated directly in the body, edge endpoints included
+    std::vector<NodeIndex> nodes;
+    std::vector<EdgeIndex> edges;
     std::vector<std::shared_ptr<Subgraph>> subgraphs;
     
     explicit Subgraph(const std::string& subgraph_id = "") : id(subgraph_id) {}
@@ -49,32 +128,130 @@ struct Graph {
     bool strict;
     std::string id;
     AttributeList attributes;
+    // Defaults in effect at the end of the body
+    AttributeSet node_defaults;
+    AttributeSet edge_defaults;
+    // Every node and edge of the graph, subgraph contents included, in
+    // order of first appearance
     std::vector<std::shared_ptr<Node>> nodes;
     std::vector<std::shared_ptr<Edge>> edges;
     std::vector<std::shared_ptr<Subgraph>> subgraphs;
+    // Names and values of every attribute in the graph
+    SymbolTable symbols;
+    // Node IDs to indices in nodes
+    NodeTable node_table;
     
     Graph() : type(DIGRAPH), strict(false) {}
+    Graph(const Graph&) = delete;
+    Graph& operator=(const Graph&) = delete;
+    
+    // NO_NODE if there is no node with this ID
+    NodeIndex find_node(std::string_view id) const { return node_table.find(id); }
+};
+
+// Attribute as seen by the parser. Both views point into the lexer's
+// buffers and are only valid during the GraphBuilder call they are passed to.
+struct AttributeView {
+    std::string_view name;
+    std::string_view value;
+};
+
+using AttributeViews = std::vector<AttributeView>;
+
+// Receives the structure of a DOT document from DotParser, statement by
+// statement, and builds whatever representation it needs from it.
+class GraphBuilder {
+public:
+    virtual ~GraphBuilder() = default;
+    
+    virtual void begin_graph(Graph::Type type, bool strict, std::string_view id) = 0;
+    virtual void end_graph() = 0;
+    virtual void begin_subgraph(std::string_view id) = 0;
+    virtual void end_subgraph() = 0;
+    
+    virtual void add_node(std::string_view id, const AttributeViews& attributes) = 0;
+    virtual void add_edge(std::string_view source, std::string_view target,
+                          const AttributeViews& attributes) = 0;
+    // kind is GRAPH, NODE or EDGE; "ID = ID" statements arrive as GRAPH
+    virtual void add_attributes(TokenType kind, const AttributeViews& attributes) = 0;
+};
+
+// Builds the shared_ptr based dot::Graph
+class AstBuilder : public GraphBuilder {
+public:
+    explicit AstBuilder(std::shared_ptr<Graph> graph = std::make_shared<Graph>());
+    
+    std::shared_ptr<Graph> graph() const { return graph_; }
+    
+    void begin_graph(Graph::Type type, bool strict, std::string_view id) override;
+    void end_graph() override;
+    void begin_subgraph(std::string_view id) override;
+    void end_subgraph() override;
+    void add_node(std::string_view id, const AttributeViews& attributes) override;
+    void add_edge(std::string_view source, std::string_view target,
+                  const AttributeViews& attributes) override;
+    void add_attributes(TokenType kind, const AttributeViews& attributes) override;
+    
+    // Counterparts of add_node, add_edge and add_attributes for elements
+    // built elsewhere, e.g. on parse_parallel workers. Attribute values must
+    // be stored in the graph's symbol table or one it adopted. A node that
+    // already exists absorbs the attributes of node instead of being replaced.
+    void merge_node(std::shared_ptr<Node> node, uint32_t id_hash);
+    void merge_edge(std::shared_ptr<Edge> edge,
+                    std::string_view source, uint32_t source_hash,
+                    std::string_view target, uint32_t target_hash);
+    void merge_attributes(TokenType kind, const AttributeList& attributes);
+    
+private:
+    // Node and edge defaults of an open graph or subgraph body. Nested
+    // scopes start out sharing the sets of their parent.
+    struct Scope {
+        AttributeSet node_defaults;
+        AttributeSet edge_defaults;
+        // Nodes already listed as members of the subgraph
+        std::unordered_set<NodeIndex> members;
+    };
+    
+    std::shared_ptr<Graph> graph_;
+    std::vector<std::shared_ptr<Subgraph>> subgraph_stack_;
+    std::vector<Scope> scopes_;
+    
+    NodeIndex resolve_node(std::string_view id, uint32_t id_hash, std::shared_ptr<Node> node = nullptr);
+    void append_edge(std::shared_ptr<Edge> edge);
+    AttributeList& attribute_target();
+    void store_attributes(AttributeList& target, const AttributeViews& attributes);
+    AttributeSet merge_defaults(const AttributeSet& defaults, const AttributeViews& attributes);
+    AttributeSet merge_defaults(const AttributeSet& defaults, const AttributeList& attributes);
 };
 
 class DotParser {
 public:
     explicit DotParser(const std::string& text);
+    // Parses a caller-owned buffer in place; see DotLexer(const char*, size_t).
+    DotParser(const char* data, size_t size);
     
     std::shared_ptr<Graph> parse();
+    // Parses the whole document into builder
+    void parse(GraphBuilder& builder);
+    
+    // Incremental entry points used by DotPushParser: the graph header up
+    // to and including '{', and body statements up to '}' or end of input.
+    void parse_header(GraphBuilder& builder);
+    void parse_statements(GraphBuilder& builder);
     
 private:
     DotLexer lexer_;
     Token current_token_;
+    AttributeViews attributes_;
+    size_t depth_;
     
     void consume(TokenType expected_type);
     void advance();
     
-    std::shared_ptr<Graph> parse_graph();
-    std::shared_ptr<Subgraph> parse_subgraph();
-    std::shared_ptr<Node> parse_node();
-    std::shared_ptr<Edge> parse_edge(const std::string& source_id);
-    AttributeList parse_attributes();
-    std::string parse_id();
+    void parse_statement(GraphBuilder& builder);
+    void parse_subgraph(GraphBuilder& builder);
+    void parse_attributes();
+    std::string_view parse_id();
     
     bool is_node_statement();
     bool is_edge_statement();
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "parser.h"
+#include "statement_splitter.h"
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace xdot_cpp {
+namespace dot {
+
+// Elements appended to the graph by one top-level statement. Nodes count
+// only when the statement is their first mention; nodes and edges inside
+// subgraphs are included.
+struct StatementRange {
+    size_t first_node;
+    size_t node_count;
+    size_t first_edge;
+    size_t edge_count;
+    size_t first_subgraph;
+    size_t subgraph_count;
+};
+
+// Resumable DOT parser for chunked input such as a Graphviz pipe. Bytes are
+// fed as they arrive; every top-level statement is parsed into the graph as
+// soon as its last byte is seen, so only the current incomplete statement
+// is buffered.
+class DotPushParser {
+public:
+    using StatementCallback = std::function<void(const Graph& graph, const StatementRange& added)>;
+
+    explicit DotPushParser(StatementCallback on_statement = StatementCallback());
+    // Reports the document to builder instead of building a Graph; graph()
+    // and finish() then return an empty graph
+    explicit DotPushParser(GraphBuilder& builder);
+
+    DotPushParser(const DotPushParser&) = delete;
+    DotPushParser& operator=(const DotPushParser&) = delete;
+
+    void feed(const char* data, size_t size);
+    // Checks that the graph was closed and returns it
+    std::shared_ptr<Graph> finish();
+
+    // The graph parsed so far
+    std::shared_ptr<Graph> graph() const { return ast_builder_.graph(); }
+    bool finished() const { return splitter_.finished(); }
+
+private:
+    StatementSplitter splitter_;
+    StatementCallback on_statement_;
+    AstBuilder ast_builder_;
+    GraphBuilder& builder_;
+    std::vector<StatementSplitter::Range> ranges_;
+
+    // Unconsumed input, starting at stream offset buffer_offset_
+    std::string buffer_;
+    size_t buffer_offset_;
+    // Line and column of buffer_[0], for error positions
+    SourceLocation buffer_location_;
+
+    void parse_range(const StatementSplitter::Range& range);
+    void discard_until(size_t offset);
+    SourceLocation absolute_location(size_t buffer_pos, const ParseError& error) const;
+};
+
+} // namespace dot
+} // namespace xdot_cpp
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "lexer.h"
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace xdot_cpp {
+namespace dot {
+
+// Character classes used by the DOT lexer hot loops
+enum CharClass : uint8_t {
+    CC_SPACE = 1 << 0,     // ' ', \t, \n, \v, \f, \r
+    CC_DIGIT = 1 << 1,     // 0-9
+    CC_ID_START = 1 << 2,  // A-Z, a-z, _, and bytes >= 0x80 (UTF-8)
+    CC_ID_CHAR = 1 << 3,   // CC_ID_START plus digits
+    CC_PUNCT = 1 << 4      // single-character tokens: [ ] { } , : ; = +
+};
+
+struct CharClassTable {
+    uint8_t classes[256];
+
+    constexpr CharClassTable() : classes() {
+        for (int c = 0; c < 256; c++) {
+            uint8_t cls = 0;
+            if (c == ' ' || (c >= '\t' && c <= '\r')) cls |= CC_SPACE;
+            if (c >= '0' && c <= '9') cls |= CC_DIGIT | CC_ID_CHAR;
+            if ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c == '_' || c >= 0x80) {
+                cls |= CC_ID_START | CC_ID_CHAR;
+            }
+            switch (c) {
+                case '[': case ']': case '{': case '}': case ',':
+                case ':': case ';': case '=': case '+':
+                    cls |= CC_PUNCT;
+                    break;
+            }
+            classes[c] = cls;
+        }
+    }
+
+    constexpr bool is(char c, uint8_t cls) const {
+        return (classes[static_cast<unsigned char>(c)] & cls) != 0;
+    }
+};
+
+inline constexpr CharClassTable char_classes{};
+
+// Perfect-hash lookup of the (case-independent) DOT keywords. Returns
+// TokenType::ID when text is not a keyword.
+TokenType lookup_keyword(std::string_view text);
+
+// Bulk scanners over [pos, end). Each returns the offset of the first byte
+// that stops the run, or end. They use AVX2 or SSE2 when the CPU supports
+// it and fall back to the class table otherwise.
+namespace scan {
+
+size_t skip_whitespace(const char* data, size_t pos, size_t end);
+size_t skip_identifier(const char* data, size_t pos, size_t end);
+// Stops at the first '"' or '\\'
+size_t skip_string_body(const char* data, size_t pos, size_t end);
+
+// Name of the kernel set picked at startup ("avx2", "sse2" or "scalar")
+const char* kernel_name();
+
+} // namespace scan
+
+} // namespace dot
+} // namespace xdot_cpp
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace xdot_cpp {
+namespace dot {
+
+// Finds the boundaries of top-level statements in a DOT byte stream without
+// tokenizing it. Quoted strings (including split escapes), HTML <...>
+// strings, comments, attribute lists and nested subgraph bodies are
+// tracked so only boundaries of the outermost graph body are reported.
+// Input may arrive in arbitrary chunks; all state survives between calls.
+class StatementSplitter {
+public:
+    enum class RangeKind {
+        HEADER,     // "[strict] (graph|digraph) [ID] {"
+        STATEMENT,  // one body statement, including any trailing ';'
+        END         // the closing '}' of the graph
+    };
+
+    // Byte range [begin, end) in absolute stream offsets
+    struct Range {
+        RangeKind kind;
+        size_t begin;
+        size_t end;
+    };
+
+    StatementSplitter();
+
+    // A splitter positioned between two statements of the graph body at
+    // stream offset offset, for scanning from the middle of a document
+    static StatementSplitter in_body(size_t offset);
+
+    // Scans the next chunk and appends every range completed by it to out
+    void feed(const char* data, size_t size, std::vector<Range>& out);
+
+    // Total number of bytes fed so far
+    size_t offset() const { return offset_; }
+    // Start of the first byte not yet covered by a reported range
+    size_t pending_begin() const { return statement_begin_; }
+    // True once the closing '}' of the graph has been seen
+    bool finished() const { return finished_; }
+    // True if only whitespace and comments follow the last statement
+    // boundary, i.e. the state in_body() starts from
+    bool between_statements() const {
+        return state_ == State::NORMAL && last_ == Last::NONE && at_body_level() && !finished_;
+    }
+
+private:
+    enum class State : uint8_t {
+        NORMAL,
+        IDENTIFIER,
+        STRING,
+        STRING_ESCAPE,
+        HTML,
+        SLASH,
+        LINE_COMMENT,
+        BLOCK_COMMENT,
+        BLOCK_COMMENT_STAR,
+        DASH
+    };
+
+    // What the last significant token of the current statement was
+    enum class Last : uint8_t {
+        NONE,          // nothing yet: statement start
+        OPERAND,       // ID, string, ']' or a closed subgraph body
+        OPERATOR,      // '=', edge op, ':', ',', '+', '[' or an attribute keyword
+        SUBGRAPH_HEAD  // 'subgraph' keyword, optionally followed by its ID
+    };
+
+    State state_;
+    Last last_;
+    size_t offset_;
+    size_t statement_begin_;
+    size_t brace_depth_;
+    size_t bracket_depth_;
+    size_t html_depth_;
+    size_t dash_pos_;
+    char keyword_[9];
+    size_t keyword_length_;
+    bool finished_;
+
+    bool at_body_level() const { return brace_depth_ == 1 && bracket_depth_ == 0; }
+    void begin_operand(size_t pos, std::vector<Range>& out);
+    void end_identifier();
+    void close_range(RangeKind kind, size_t end, std::vector<Range>& out);
+    void scan_normal(char c, size_t pos, std::vector<Range>& out);
+};
+
+} // namespace dot
+} // namespace xdot_cpp
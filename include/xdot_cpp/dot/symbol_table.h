@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace xdot_cpp {
+namespace dot {
+
+using Symbol = uint32_t;
+
+constexpr Symbol NO_SYMBOL = UINT32_MAX;
+
+// Attribute names interned by every SymbolTable up front, so their symbols
+// are compile-time constants
+namespace symbols {
+
+enum : Symbol {
+    LABEL,
+    POS,
+    WIDTH,
+    HEIGHT,
+    SHAPE,
+    STYLE,
+    COLOR,
+    FILLCOLOR,
+    FONTNAME,
+    FONTSIZE,
+    FONTCOLOR,
+    BB,
+    LP,
+    URL,
+    DRAW,     // _draw_
+    LDRAW,    // _ldraw_
+    HDRAW,    // _hdraw_
+    TDRAW,    // _tdraw_
+    HLDRAW,   // _hldraw_
+    TLDRAW,   // _tldraw_
+    WELL_KNOWN_COUNT
+};
+
+std::string_view well_known_name(Symbol symbol);
+
+// Whether values of this attribute are worth deduplicating. Positions and
+// drawing operations are practically unique per element.
+bool interns_values(Symbol symbol);
+
+} // namespace symbols
+
+// Per-graph string interner. Attribute names map to dense integer symbols;
+// short, repetitive values are deduplicated through the same table, and
+// everything else is copied into its arena without deduplication.
+class SymbolTable {
+public:
+    SymbolTable();
+
+    SymbolTable(const SymbolTable&) = delete;
+    SymbolTable& operator=(const SymbolTable&) = delete;
+
+    Symbol intern(std::string_view text);
+    // NO_SYMBOL if text was never interned
+    Symbol find(std::string_view text) const;
+    std::string_view name(Symbol symbol) const { return names_[symbol]; }
+
+    // Storage for the value of attribute name, interned when that pays off
+    std::string_view store_value(Symbol name, std::string_view value);
+    // Copies text into the arena without deduplication
+    std::string_view store(std::string_view text);
+
+    // Keeps the strings of another table alive as long as this one, for
+    // values stored there and then moved into this table's graph. Its
+    // symbols are not merged; callers map names through intern().
+    void adopt(std::unique_ptr<SymbolTable> table);
+
+    size_t size() const { return names_.size(); }
+    // Bytes of string data held by the table, adopted tables included
+    size_t bytes() const { return bytes_; }
+
+private:
+    std::pmr::monotonic_buffer_resource arena_;
+    std::vector<std::string_view> names_;
+    std::unordered_map<std::string_view, Symbol> index_;
+    std::vector<std::unique_ptr<SymbolTable>> adopted_;
+    size_t bytes_;
+};
+
+} // namespace dot
+} // namespace xdot_cpp
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "parser.h"
+#include <cstddef>
+#include <istream>
+#include <string>
+#include <string_view>
+
+namespace xdot_cpp {
+namespace dot {
+
+// Event interface for streaming over a DOT document without building a
+// Graph. Every statement is reported as it is parsed: on_node, on_edge or
+// on_attributes opens it, one on_attribute call follows per attribute in
+// its list, and on_statement_end closes it. All string views are valid
+// until the on_statement_end (or subgraph/graph event) they belong to;
+// copy what you need to keep. Nodes and edges are reported as written:
+// repeated node statements are not merged and defaults are not applied.
+class DotVisitor {
+public:
+    virtual ~DotVisitor() = default;
+
+    virtual void on_graph_begin(Graph::Type /*type*/, bool /*strict*/, std::string_view /*id*/) {}
+    virtual void on_graph_end() {}
+    virtual void on_subgraph_begin(std::string_view /*id*/) {}
+    virtual void on_subgraph_end() {}
+
+    virtual void on_node(std::string_view /*id*/) {}
+    virtual void on_edge(std::string_view /*source*/, std::string_view /*target*/) {}
+    // kind is GRAPH, NODE or EDGE; "ID = ID" statements arrive as GRAPH
+    virtual void on_attributes(TokenType /*kind*/) {}
+    virtual void on_attribute(std::string_view /*name*/, std::string_view /*value*/) {}
+    virtual void on_statement_end() {}
+};
+
+// Feeds DotParser or DotPushParser events to a DotVisitor
+class VisitorAdapter : public GraphBuilder {
+public:
+    explicit VisitorAdapter(DotVisitor& visitor) : visitor_(visitor) {}
+
+    void begin_graph(Graph::Type type, bool strict, std::string_view id) override;
+    void end_graph() override;
+    void begin_subgraph(std::string_view id) override;
+    void end_subgraph() override;
+    void add_node(std::string_view id, const AttributeViews& attributes) override;
+    void add_edge(std::string_view source, std::string_view target,
+                  const AttributeViews& attributes) override;
+    void add_attributes(TokenType kind, const AttributeViews& attributes) override;
+
+private:
+    DotVisitor& visitor_;
+
+    void report_attributes(const AttributeViews& attributes);
+};
+
+void visit(const std::string& text, DotVisitor& visitor);
+// Parses a caller-owned buffer in place
+void visit(const char* data, size_t size, DotVisitor& visitor);
+// Reads in fixed-size chunks through DotPushParser. Only the current
+// top-level statement is held in memory, so documents larger than RAM
+// can be processed as long as no single statement is.
+void visit(std::istream& in, DotVisitor& visitor);
+
+} // namespace dot
+} // namespace xdot_cpp
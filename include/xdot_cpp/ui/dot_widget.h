@@ -2,6 +2,8 @@
 
 #include "../xdot/graph.h"
 #include "../xdot/elements.h"
+#include "../xdot/display_list.h"
+#include "../xdot/xdot_parser.h"
 #include <QWidget>
 #include <QGraphicsView>
 #include <QGraphicsScene>
@@ -10,25 +12,49 @@
 #include <QMouseEvent>
 #include <QWheelEvent>
 #include <QKeyEvent>
+#include <QProcess>
+#include <QTimer>
 #include <memory>
+#include <unordered_map>
 
 namespace xdot_cpp {
 namespace ui {
 
-class QtRenderer : public xdot::Renderer {
+// Final, so DisplayList::draw() calls it directly
+class QtRenderer final : public xdot::Renderer {
 public:
     explicit QtRenderer(QPainter* painter);
     
     void draw_ellipse(const xdot::Point& center, double width, double height, const xdot::Pen& pen) override;
-    void draw_polygon(const std::vector<xdot::Point>& points, const xdot::Pen& pen) override;
-    void draw_polyline(const std::vector<xdot::Point>& points, const xdot::Pen& pen) override;
-    void draw_bezier(const std::vector<xdot::Point>& control_points, const xdot::Pen& pen) override;
-    void draw_text(const xdot::Point& position, const std::string& text, const xdot::Pen& pen) override;
-    void draw_image(const xdot::Point& position, double width, double height, const std::string& path) override;
+    void draw_polygon(const xdot::Point* points, size_t count, const xdot::Pen& pen) override;
+    void draw_polygon_instance(const std::vector<xdot::Point>& prototype, const xdot::Placement& placement,
+                               const xdot::Pen& pen) override;
+    void draw_polyline(const xdot::Point* points, size_t count, const xdot::Pen& pen) override;
+    void draw_bezier(const xdot::Point* control_points, size_t count, const xdot::Pen& pen) override;
+    void draw_text(const xdot::Point& position, std::string_view text, const xdot::Pen& pen) override;
+    void draw_image(const xdot::Point& position, double width, double height, std::string_view path) override;
+    double flatness() const override { return flatness_; }
+    
+    // Draw curves as cached polylines within flatness graph units
+    void set_flatness(double flatness) { flatness_ = flatness; }
     
 private:
+    // Qt objects for one pen. Shapes of a graph share the pens of its
+    // PenPool, so the cache is keyed by pool entry address.
+    struct PenObjects {
+        QPen pen;
+        QBrush brush;
+        QFont font;
+    };
+    
     QPainter* painter_;
+    double flatness_;
+    std::unordered_map<const xdot::Pen*, PenObjects> pen_cache_;
+    // Prototype outlines, keyed by PrototypePool entry address like pens
+    std::unordered_map<const std::vector<xdot::Point>*, QPolygonF> prototype_cache_;
     
+    const PenObjects& pen_objects(const xdot::Pen& pen);
+    const QPolygonF& prototype_polygon(const std::vector<xdot::Point>& prototype);
     QPen create_qpen(const xdot::Pen& pen);
     QBrush create_qbrush(const xdot::Pen& pen);
     QFont create_qfont(const xdot::Pen& pen);
@@ -40,11 +66,23 @@ class DotWidget : public QGraphicsView {
     
 public:
     explicit DotWidget(QWidget* parent = nullptr);
+    ~DotWidget() override;
     
     void set_graph(std::shared_ptr<xdot::GraphElement> graph);
+    // Lays the graph out with Graphviz in the background. The output is
+    // parsed and decoded as dot writes it, and shown as it arrives.
     void set_dot_code(const std::string& dot_code);
     void set_xdot_code(const std::string& xdot_code);
     
+    // Decode node and edge geometry only when it is first drawn or
+    // hit-tested, and draw only what is in view. Applies to the next
+    // set_dot_code().
+    void set_lazy_decoding(bool lazy) { lazy_decoding_ = lazy; }
+    // Memory kept for decoded geometry of lazily decoded graphs, in bytes.
+    // Geometry past the budget is dropped and decoded again when needed;
+    // 0 keeps everything.
+    void set_shape_budget(size_t bytes);
+    
     void zoom_to_fit();
     void zoom_in();
     void zoom_out();
@@ -67,10 +105,14 @@ protected:
     void mouseReleaseEvent(QMouseEvent* event) override;
     void keyPressEvent(QKeyEvent* event) override;
     void paintEvent(QPaintEvent* event) override;
+    void drawBackground(QPainter* painter, const QRectF& rect) override;
     void resizeEvent(QResizeEvent* event) override;
     
 private slots:
     void update_scene();
+    void on_dot_output();
+    void on_dot_finished(int exit_code, QProcess::ExitStatus exit_status);
+    void publish_loaded();
     
 private:
     std::shared_ptr<xdot::GraphElement> graph_;
@@ -80,14 +122,29 @@ private:
     bool dragging_;
     QPoint last_pan_point_;
     double zoom_factor_;
+    bool lazy_decoding_;
+    size_t shape_budget_;
+    
+    // Graphviz run being loaded
+    QProcess* dot_process_;
+    QTimer* publish_timer_;
+    std::unique_ptr<xdot::SceneLoader> scene_loader_;
+    // Lazy decoding needs the whole dot::Graph instead
+    std::unique_ptr<dot::DotPushParser> dot_parser_;
     
     std::shared_ptr<xdot::GraphNode> highlighted_node_;
     std::shared_ptr<xdot::GraphEdge> highlighted_edge_;
     
     void setup_scene();
+    void cancel_load();
+    // Whether the graph is drawn per exposed area rather than into a pixmap
+    bool draws_visible_only() const;
     void render_graph();
-    void render_shapes(const std::vector<std::shared_ptr<xdot::Shape>>& shapes, QPainter* painter);
+    void render_visible(QPainter* painter, const QRectF& rect);
     
+    // CURVE_FLATNESS_PX at the current zoom, in graph units; used for
+    // both drawing and hit-testing curves
+    double curve_flatness() const;
     std::shared_ptr<xdot::GraphNode> find_node_at_position(const QPoint& pos);
     std::shared_ptr<xdot::GraphEdge> find_edge_at_position(const QPoint& pos);
     
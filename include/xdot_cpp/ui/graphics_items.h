@@ -1,6 +1,6 @@
 #pragma once
 
-#include "../xdot/elements.h"
+#include "../xdot/display_list.h"
 #include <QGraphicsItem>
 #include <QPainter>
 #include <QStyleOptionGraphicsItem>
@@ -11,18 +11,22 @@ namespace ui {
 
 class GraphicsShapeItem : public QGraphicsItem {
 public:
-    explicit GraphicsShapeItem(std::shared_ptr<xdot::Shape> shape, QGraphicsItem* parent = nullptr);
+    // Draws operations ops of list
+    GraphicsShapeItem(std::shared_ptr<const xdot::DisplayList> list, xdot::OpRange ops,
+                      QGraphicsItem* parent = nullptr);
     
     QRectF boundingRect() const override;
     void paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget = nullptr) override;
     
-    std::shared_ptr<xdot::Shape> shape() const { return shape_; }
+    const xdot::DisplayList& display_list() const { return *list_; }
+    xdot::OpRange ops() const { return ops_; }
     
 protected:
     bool contains(const QPointF& point) const override;
     
 private:
-    std::shared_ptr<xdot::Shape> shape_;
+    std::shared_ptr<const xdot::DisplayList> list_;
+    xdot::OpRange ops_;
     mutable QRectF bounding_rect_;
     mutable bool bounding_rect_valid_;
     
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <map>
 
 namespace xdot_cpp {
@@ -12,7 +13,7 @@ struct Color {
     Color(double red = 0.0, double green = 0.0, double blue = 0.0, double alpha = 1.0)
         : r(red), g(green), b(blue), a(alpha) {}
     
-    static Color from_hex(const std::string& hex);
+    static Color from_hex(std::string_view hex);
     static Color from_hsv(double h, double s, double v);
     static Color from_name(const std::string& name);
     
@@ -22,10 +23,11 @@ struct Color {
 
 class ColorLookup {
 public:
-    static Color lookup_color(const std::string& color_spec);
+    // Does not allocate
+    static Color lookup_color(std::string_view color_spec);
     
 private:
-    static std::map<std::string, Color> color_map_;
+    static std::map<std::string, Color, std::less<>> color_map_;
     static void init_color_map();
 };
 
@@ -0,0 +1,155 @@
+#pragma once
+
+#include "elements.h"
+#include "prototype_pool.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace xdot_cpp {
+namespace xdot {
+
+enum class DrawOp : uint8_t {
+    ELLIPSE,   // points: center, (width, height)
+    POLYGON,   // points: (cos, sin), offset; prototype: vertices
+    POLYLINE,  // points: vertices
+    BEZIER,    // points: control points
+    TEXT,      // points: position; string: text
+    IMAGE      // points: position, (width, height); string: path
+};
+
+// Operations [first, end) of a DisplayList
+struct OpRange {
+    uint32_t first = 0;
+    uint32_t end = 0;
+
+    uint32_t size() const { return end - first; }
+    bool empty() const { return first == end; }
+};
+
+// Drawing operations in flat arrays, in drawing order. Operation i has an
+// opcode, a pen of pens(), points [point_offsets[i], point_offsets[i + 1])
+// of one shared buffer and, for text and images, a string or, for
+// polygons, a prototype of prototypes(). Nodes, edges and backgrounds
+// each own a range of a list; drawing and hit-testing walk the arrays
+// without virtual calls.
+//
+// Operations are only appended. Const members may be called from several
+// threads while nothing is appended.
+class DisplayList {
+public:
+    // Default flattening tolerance of hit tests, in graph units
+    static constexpr double HIT_FLATNESS = 0.25;
+
+    DisplayList(std::shared_ptr<PenPool> pens, std::shared_ptr<PrototypePool> prototypes);
+    DisplayList(const DisplayList&) = delete;
+    DisplayList& operator=(const DisplayList&) = delete;
+
+    const std::shared_ptr<PenPool>& pens() const { return pens_; }
+    const std::shared_ptr<PrototypePool>& prototypes() const { return prototypes_; }
+
+    size_t size() const { return ops_.size(); }
+    OpRange all() const { return {0, static_cast<uint32_t>(ops_.size())}; }
+    DrawOp op(size_t i) const { return ops_[i]; }
+    // An entry of pens(), read without locking the pool
+    const Pen& pen(size_t i) const { return *op_pens_[i]; }
+    const Point* points(size_t i) const { return points_.data() + point_offsets_[i]; }
+    size_t point_count(size_t i) const { return point_offsets_[i + 1] - point_offsets_[i]; }
+    std::string_view string(size_t i) const;
+    const std::vector<Point>& prototype(size_t i) const { return *prototype_entries_[indices_[i]]; }
+    Placement placement(size_t i) const;
+
+    // Appending; pens are entries of pens()
+    void add_ellipse(const Point& center, Coord width, Coord height, const Pen* pen);
+    // Interns the outline into prototypes()
+    void add_polygon(const Point* points, size_t count, const Pen* pen);
+    void add_polyline(const Point* points, size_t count, const Pen* pen);
+    void add_bezier(const Point* control_points, size_t count, const Pen* pen);
+    void add_text(const Point& position, std::string_view text, const Pen* pen);
+    void add_image(const Point& position, Coord width, Coord height, std::string_view path);
+    // Releases the spare capacity of the arrays
+    void shrink_to_fit();
+
+    BoundingBox op_bounds(size_t i) const;
+    // How far outside op_bounds() op_contains() can hit
+    double op_hit_margin(size_t i) const;
+    // Curves are followed within flatness graph units. Drawing with the
+    // same tolerance reuses their flattening.
+    bool op_contains(size_t i, const Point& p, double flatness = HIT_FLATNESS) const;
+    // Union of the operations' boxes, an empty box at the origin for none
+    BoundingBox bounds(OpRange ops) const;
+    double hit_margin(OpRange ops) const;
+    bool contains(OpRange ops, const Point& p, double flatness = HIT_FLATNESS) const;
+
+    // Curve i flattened within tolerance. The last flattening is kept and
+    // reused for coarser tolerances up to a point, so hit tests and
+    // drawing at a steady zoom level flatten once.
+    std::shared_ptr<const FlattenedBezier> flattened(size_t i, double tolerance) const;
+
+    // Takes the renderer by its own type, so the calls of a final class
+    // are not virtual
+    template <typename Target>
+    void draw(OpRange ops, Target& renderer) const;
+
+    // Approximate heap footprint, for cache budgets
+    size_t memory_usage() const;
+
+private:
+    std::vector<DrawOp> ops_;
+    std::vector<const Pen*> op_pens_;
+    std::vector<uint32_t> point_offsets_;
+    // Into string_offsets_, prototype_entries_ or flattened_, depending on
+    // the operation
+    std::vector<uint32_t> indices_;
+    std::vector<Point> points_;
+    std::string strings_;
+    std::vector<uint32_t> string_offsets_;
+    std::vector<const std::vector<Point>*> prototype_entries_;
+    mutable std::vector<std::shared_ptr<const FlattenedBezier>> flattened_;
+    std::shared_ptr<PenPool> pens_;
+    // Also keeps the prototypes pointed to alive
+    std::shared_ptr<PrototypePool> prototypes_;
+
+    void add(DrawOp op, const Point* points, size_t count, const Pen* pen, uint32_t index = 0);
+    uint32_t add_string(std::string_view value);
+};
+
+template <typename Target>
+void DisplayList::draw(OpRange ops, Target& renderer) const {
+    const double flatness = renderer.flatness();
+    for (uint32_t i = ops.first; i < ops.end; i++) {
+        const Point* op_points = points(i);
+
+        switch (ops_[i]) {
+            case DrawOp::ELLIPSE:
+                renderer.draw_ellipse(op_points[0], op_points[1].x, op_points[1].y, pen(i));
+                break;
+            case DrawOp::POLYGON:
+                renderer.draw_polygon_instance(prototype(i), placement(i), pen(i));
+                break;
+            case DrawOp::POLYLINE:
+                renderer.draw_polyline(op_points, point_count(i), pen(i));
+                break;
+            case DrawOp::BEZIER:
+                if (flatness > 0.0 && point_count(i) >= 4) {
+                    auto polyline = flattened(i, flatness);
+                    renderer.draw_polyline(polyline->points.data(), polyline->points.size(), pen(i));
+                } else {
+                    renderer.draw_bezier(op_points, point_count(i), pen(i));
+                }
+                break;
+            case DrawOp::TEXT:
+                renderer.draw_text(op_points[0], string(i), pen(i));
+                break;
+            case DrawOp::IMAGE:
+                renderer.draw_image(op_points[0], op_points[1].x, op_points[1].y, string(i));
+                break;
+        }
+    }
+}
+
+} // namespace xdot
+} // namespace xdot_cpp
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "../dot/parser.h"
+#include <array>
+#include <cstddef>
+#include <string_view>
+
+namespace xdot_cpp {
+namespace xdot {
+
+// The attributes a graph element is drawn from, picked out of its
+// attribute list in a single pass. Slots are views into the attribute
+// values; nothing is copied, so they are only valid as long as those are.
+struct DrawAttributes {
+    enum Slot : uint8_t {
+        // Drawing operations, in the order their shapes are drawn
+        DRAW,     // _draw_
+        HDRAW,    // _hdraw_, head arrow
+        TDRAW,    // _tdraw_, tail arrow
+        LDRAW,    // _ldraw_
+        HLDRAW,   // _hldraw_, head label
+        TLDRAW,   // _tldraw_, tail label
+        URL,
+        SLOT_COUNT,
+        NO_SLOT = SLOT_COUNT
+    };
+
+    static constexpr size_t SHAPE_SLOT_COUNT = URL;
+
+    std::array<std::string_view, SLOT_COUNT> values;
+
+    std::string_view operator[](Slot slot) const { return values[slot]; }
+    std::string_view& operator[](Slot slot) { return values[slot]; }
+
+    // Slot of an attribute name, NO_SLOT if it is not a drawing attribute
+    static Slot slot_of(dot::Symbol name);
+    static Slot slot_of(std::string_view name);
+
+    // Fills the slots of the attributes set in attributes; others are kept
+    void classify(const dot::AttributeList& attributes);
+
+    // Element attributes over the defaults in effect where it was declared
+    static DrawAttributes of(const dot::AttributeList& attributes, const dot::AttributeSet& defaults);
+    static DrawAttributes of(const dot::AttributeList& attributes);
+};
+
+} // namespace xdot
+} // namespace xdot_cpp
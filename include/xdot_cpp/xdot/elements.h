@@ -1,128 +1,109 @@
 #pragma once
 
-#include "pen.h"
+#include "pen_pool.h"
+#include <cstddef>
+#include <string_view>
 #include <vector>
-#include <memory>
-#include <string>
 
 namespace xdot_cpp {
 namespace xdot {
 
+// Scalar type of stored coordinates. Building with XDOT_CPP_FLOAT_GEOMETRY
+// stores them as float, which halves point and box storage and doubles
+// the lanes of the geometry kernels. Graphviz writes positions with two
+// decimals; float resolves 1/100 point for coordinates below 65536.
+#ifdef XDOT_CPP_FLOAT_GEOMETRY
+using Coord = float;
+#else
+using Coord = double;
+#endif
+
 struct Point {
-    double x, y;
-    Point(double x_val = 0.0, double y_val = 0.0) : x(x_val), y(y_val) {}
+    Coord x, y;
+    Point(Coord x_val = 0, Coord y_val = 0) : x(x_val), y(y_val) {}
 };
 
 struct BoundingBox {
-    double x1, y1, x2, y2;
-    BoundingBox(double x1_val = 0.0, double y1_val = 0.0, double x2_val = 0.0, double y2_val = 0.0)
+    Coord x1, y1, x2, y2;
+    BoundingBox(Coord x1_val = 0, Coord y1_val = 0, Coord x2_val = 0, Coord y2_val = 0)
         : x1(x1_val), y1(y1_val), x2(x2_val), y2(y2_val) {}
     
     bool contains(const Point& p) const;
     bool intersects(const BoundingBox& other) const;
-    double width() const { return x2 - x1; }
-    double height() const { return y2 - y1; }
+    Coord width() const { return x2 - x1; }
+    Coord height() const { return y2 - y1; }
 };
 
-class Shape {
-public:
-    virtual ~Shape() = default;
-    virtual BoundingBox bounding_box() const = 0;
-    virtual bool contains_point(const Point& p) const = 0;
-    virtual void draw(class Renderer* renderer) const = 0;
-    
-protected:
-    Pen pen_;
+// Rotation and offset that place a shared prototype in the graph
+struct Placement {
+    Coord cos = 1;
+    Coord sin = 0;
+    Point offset;
+    
+    Point apply(const Point& p) const {
+        return Point(offset.x + cos * p.x - sin * p.y, offset.y + sin * p.x + cos * p.y);
+    }
+    // Prototype coordinates of a graph point
+    Point unapply(const Point& p) const {
+        Coord dx = p.x - offset.x;
+        Coord dy = p.y - offset.y;
+        return Point(cos * dx + sin * dy, cos * dy - sin * dx);
+    }
 };
 
-class EllipseShape : public Shape {
-public:
-    EllipseShape(const Point& center, double width, double height, const Pen& pen);
-    
-    BoundingBox bounding_box() const override;
-    bool contains_point(const Point& p) const override;
-    void draw(Renderer* renderer) const override;
-    
-private:
-    Point center_;
-    double width_, height_;
-};
+class PrototypePool;
+using PrototypeIndex = uint32_t;
 
-class PolygonShape : public Shape {
-public:
-    PolygonShape(const std::vector<Point>& points, const Pen& pen);
-    
-    BoundingBox bounding_box() const override;
-    bool contains_point(const Point& p) const override;
-    void draw(Renderer* renderer) const override;
-    
-private:
-    std::vector<Point> points_;
-};
+// Geometry tests of the DisplayList operations
+BoundingBox points_bounding_box(const Point* points, size_t count);
+bool polygon_contains(const Point* points, size_t count, const Point& p);
+// Whether p is within tolerance of the polyline through points
+bool polyline_near(const Point* points, size_t count, const Point& p, double tolerance);
+// Whether p is within tolerance of any of points
+bool points_near(const Point* points, size_t count, const Point& p, double tolerance);
+bool ellipse_contains(const Point& center, double width, double height, const Point& p);
+BoundingBox text_bounding_box(const Point& position, size_t length, double font_size);
 
-class PolylineShape : public Shape {
-public:
-    PolylineShape(const std::vector<Point>& points, const Pen& pen);
-    
-    BoundingBox bounding_box() const override;
-    bool contains_point(const Point& p) const override;
-    void draw(Renderer* renderer) const override;
-    
-private:
-    std::vector<Point> points_;
+// A piecewise cubic Bezier (control points 3n + 1) as a polyline within
+// tolerance of the curve. Segment i of the curve ends at points[segment_ends[i]]
+// and starts where segment i - 1 ends.
+struct FlattenedBezier {
+    double tolerance = 0.0;
+    std::vector<Point> points;
+    std::vector<uint32_t> segment_ends;
 };
 
-class BezierShape : public Shape {
-public:
-    BezierShape(const std::vector<Point>& control_points, const Pen& pen);
-    
-    BoundingBox bounding_box() const override;
-    bool contains_point(const Point& p) const override;
-    void draw(Renderer* renderer) const override;
-    
-private:
-    std::vector<Point> control_points_;
-};
-
-class TextShape : public Shape {
-public:
-    TextShape(const Point& position, const std::string& text, const Pen& pen);
-    
-    BoundingBox bounding_box() const override;
-    bool contains_point(const Point& p) const override;
-    void draw(Renderer* renderer) const override;
-    
-    const std::string& text() const { return text_; }
-    
-private:
-    Point position_;
-    std::string text_;
-};
-
-class ImageShape : public Shape {
-public:
-    ImageShape(const Point& position, double width, double height, const std::string& path);
-    
-    BoundingBox bounding_box() const override;
-    bool contains_point(const Point& p) const override;
-    void draw(Renderer* renderer) const override;
-    
-private:
-    Point position_;
-    double width_, height_;
-    std::string image_path_;
-};
+// Subdivides each segment until its control points are within tolerance
+// of the chord
+FlattenedBezier flatten_bezier(const Point* control_points, size_t count, double tolerance);
+// Whether p is within distance of the curve, up to the flattening
+// tolerance. Segments whose control points are not near p are skipped.
+bool bezier_near(const Point* control_points, size_t count, const FlattenedBezier& flattened,
+                 const Point& p, double distance);
+// Same, flattening only the segments near p
+bool bezier_near(const Point* control_points, size_t count, const Point& p, double distance,
+                 double tolerance);
 
+// Receives the operations of a DisplayList. DisplayList::draw() is a
+// template over the renderer type, so a final renderer is called directly.
 class Renderer {
 public:
     virtual ~Renderer() = default;
     
     virtual void draw_ellipse(const Point& center, double width, double height, const Pen& pen) = 0;
-    virtual void draw_polygon(const std::vector<Point>& points, const Pen& pen) = 0;
-    virtual void draw_polyline(const std::vector<Point>& points, const Pen& pen) = 0;
-    virtual void draw_bezier(const std::vector<Point>& control_points, const Pen& pen) = 0;
-    virtual void draw_text(const Point& position, const std::string& text, const Pen& pen) = 0;
-    virtual void draw_image(const Point& position, double width, double height, const std::string& path) = 0;
+    virtual void draw_polygon(const Point* points, size_t count, const Pen& pen) = 0;
+    // A pooled outline placed in the graph. Renderers that can transform
+    // may cache what they build from prototype, keyed by its address; the
+    // default draws the placed points with draw_polygon().
+    virtual void draw_polygon_instance(const std::vector<Point>& prototype, const Placement& placement,
+                                       const Pen& pen);
+    virtual void draw_polyline(const Point* points, size_t count, const Pen& pen) = 0;
+    virtual void draw_bezier(const Point* control_points, size_t count, const Pen& pen) = 0;
+    // Tolerance in graph units within which curves may be drawn as
+    // polylines, for level of detail; 0 draws curves with draw_bezier()
+    virtual double flatness() const { return 0.0; }
+    virtual void draw_text(const Point& position, std::string_view text, const Pen& pen) = 0;
+    virtual void draw_image(const Point& position, double width, double height, std::string_view path) = 0;
 };
 
 } // namespace xdot
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "elements.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace xdot_cpp {
+namespace xdot {
+
+// Batch geometry kernels over packed arrays of Coord. Each processes several
+// vertices or boxes per instruction with AVX2 or SSE2 when the CPU
+// supports it and falls back to scalar code otherwise; all variants give
+// the same results. Distances are compared squared, without sqrt.
+namespace geometry {
+
+// Boxes stored as one array per coordinate, so that neighbouring boxes
+// sit in the same vector register
+struct BoxArrays {
+    const Coord* x1;
+    const Coord* y1;
+    const Coord* x2;
+    const Coord* y2;
+};
+
+// Bounding box of count > 0 points
+BoundingBox points_bounds(const Point* points, size_t count);
+// Union of boxes [first, first + count), count > 0
+BoundingBox union_bounds(const BoxArrays& boxes, size_t first, size_t count);
+
+// Bit i is set if box first + i contains p (resp. intersects area);
+// count <= 32
+uint32_t contains_mask(const BoxArrays& boxes, size_t first, size_t count, const Point& p);
+uint32_t intersects_mask(const BoxArrays& boxes, size_t first, size_t count, const BoundingBox& area);
+
+// Even-odd ray casting over the closed polygon through points
+bool polygon_contains(const Point* points, size_t count, const Point& p);
+// Whether p is within distance of a non-degenerate segment of the polyline
+bool polyline_near(const Point* points, size_t count, const Point& p, double distance);
+// Whether p is within distance of any of points
+bool points_near(const Point* points, size_t count, const Point& p, double distance);
+
+// Name of the kernel set in use ("avx2", "sse2" or "scalar"). The best
+// one the CPU supports is picked at startup, unless the environment
+// variable XDOT_CPP_GEOMETRY_KERNELS names another supported one.
+const char* kernel_name();
+
+// Switches to the kernel set called name, for checks that compare the
+// variants. Returns false and keeps the current set if name is not built
+// in or the CPU lacks it. Not safe while other threads use the kernels.
+bool use_kernels(const char* name);
+
+} // namespace geometry
+
+} // namespace xdot
+} // namespace xdot_cpp
@@ -1,10 +1,15 @@
 #pragma once
 
 #include "elements.h"
+#include "display_list.h"
+#include "shape_cache.h"
+#include "spatial_index.h"
 #include "../dot/parser.h"
+#include <array>
 #include <vector>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <map>
 
 namespace xdot_cpp {
@@ -12,12 +17,25 @@ namespace xdot {
 
 class GraphNode {
 public:
-    GraphNode(const std::string& id, const std::vector<std::shared_ptr<Shape>>& shapes);
+    // Drawn by operations ops of list
+    GraphNode(const std::string& id, std::shared_ptr<const DisplayList> list, OpRange ops);
+    // Shapes are decoded when needed
+    GraphNode(const std::string& id, std::unique_ptr<DeferredShapes> deferred);
     
     const std::string& id() const { return id_; }
-    const std::vector<std::shared_ptr<Shape>>& shapes() const { return shapes_; }
-    BoundingBox bounding_box() const;
-    bool contains_point(const Point& p) const;
+    // The list holding ops(); decodes deferred shapes
+    const DisplayList& display_list() const { return deferred_ ? deferred_->shapes() : *list_; }
+    OpRange ops() const { return ops_; }
+    bool is_deferred() const { return deferred_ != nullptr; }
+    // Whether the shapes are in memory
+    bool is_decoded() const { return !deferred_ || deferred_->is_decoded(); }
+    // Computed when the element is made
+    const BoundingBox& bounding_box() const { return bounds_; }
+    // How far outside the bounding box contains_point() can hit
+    double hit_margin() const { return hit_margin_; }
+    // Recomputes the bounding box after the shapes changed
+    void update_bounding_box();
+    bool contains_point(const Point& p, double flatness = DisplayList::HIT_FLATNESS) const;
     
     void set_url(const std::string& url) { url_ = url; }
     const std::string& url() const { return url_; }
@@ -27,21 +45,35 @@ public:
     
 private:
     std::string id_;
-    std::vector<std::shared_ptr<Shape>> shapes_;
+    std::shared_ptr<const DisplayList> list_;
+    std::unique_ptr<DeferredShapes> deferred_;
+    OpRange ops_;
+    BoundingBox bounds_;
+    double hit_margin_;
     std::string url_;
     bool highlighted_;
 };
 
 class GraphEdge {
 public:
-    GraphEdge(const std::string& source, const std::string& target, 
-              const std::vector<std::shared_ptr<Shape>>& shapes);
+    GraphEdge(const std::string& source, const std::string& target,
+              std::shared_ptr<const DisplayList> list, OpRange ops);
+    GraphEdge(const std::string& source, const std::string& target,
+              std::unique_ptr<DeferredShapes> deferred);
     
     const std::string& source() const { return source_; }
     const std::string& target() const { return target_; }
-    const std::vector<std::shared_ptr<Shape>>& shapes() const { return shapes_; }
-    BoundingBox bounding_box() const;
-    bool contains_point(const Point& p) const;
+    const DisplayList& display_list() const { return deferred_ ? deferred_->shapes() : *list_; }
+    OpRange ops() const { return ops_; }
+    bool is_deferred() const { return deferred_ != nullptr; }
+    bool is_decoded() const { return !deferred_ || deferred_->is_decoded(); }
+    // Computed when the element is made
+    const BoundingBox& bounding_box() const { return bounds_; }
+    // How far outside the bounding box contains_point() can hit
+    double hit_margin() const { return hit_margin_; }
+    // Recomputes the bounding box after the shapes changed
+    void update_bounding_box();
+    bool contains_point(const Point& p, double flatness = DisplayList::HIT_FLATNESS) const;
     
     void set_url(const std::string& url) { url_ = url; }
     const std::string& url() const { return url_; }
@@ -52,7 +84,11 @@ public:
 private:
     std::string source_;
     std::string target_;
-    std::vector<std::shared_ptr<Shape>> shapes_;
+    std::shared_ptr<const DisplayList> list_;
+    std::unique_ptr<DeferredShapes> deferred_;
+    OpRange ops_;
+    BoundingBox bounds_;
+    double hit_margin_;
     std::string url_;
     bool highlighted_;
 };
@@ -63,16 +99,45 @@ public:
     
     void add_node(std::shared_ptr<GraphNode> node);
     void add_edge(std::shared_ptr<GraphEdge> edge);
-    void add_background_shape(std::shared_ptr<Shape> shape);
+    // Marks operations of display_list() as background, drawn below the
+    // nodes and edges
+    void add_background(OpRange ops);
     
     const std::vector<std::shared_ptr<GraphNode>>& nodes() const { return nodes_; }
     const std::vector<std::shared_ptr<GraphEdge>>& edges() const { return edges_; }
-    const std::vector<std::shared_ptr<Shape>>& background_shapes() const { return background_shapes_; }
+    const std::vector<OpRange>& background() const { return background_; }
+    // Operations of the graph itself. Backgrounds are decoded into it, and
+    // XDotSceneBuilder decodes nodes and edges into it too.
+    const std::shared_ptr<DisplayList>& display_list() const { return display_list_; }
+    // Pens of all shapes in the graph
+    const std::shared_ptr<PenPool>& pens() const { return pens_; }
+    // Outlines shared by congruent polygons
+    const std::shared_ptr<PrototypePool>& prototypes() const { return prototypes_; }
+    // Holds the decoded shapes of deferred nodes and edges
+    const std::shared_ptr<ShapeCache>& shape_cache() const { return shape_cache_; }
+    // Memory for decoded deferred shapes in bytes, 0 for no limit
+    void set_shape_budget(size_t bytes) { shape_cache_->set_budget(bytes); }
     
+    // Kept up to date as elements are added
     BoundingBox bounding_box() const;
+    // Call after updating the bounding box of a node or edge already in
+    // the graph; the next bounding_box() recomputes the graph's and the
+    // next query rebuilds the spatial indices
+    void invalidate_bounding_box();
     
-    std::shared_ptr<GraphNode> find_node_at(const Point& p) const;
-    std::shared_ptr<GraphEdge> find_edge_at(const Point& p) const;
+    // Whether some nodes or edges were added with deferred shapes
+    bool has_deferred_shapes() const { return has_deferred_shapes_; }
+    
+    // Topmost element containing p, i.e. the last one drawn. Candidates
+    // come from a spatial index built on first use after the graph changed.
+    // Curves are followed within flatness graph units; a view passes the
+    // tolerance it draws curves with at its zoom.
+    std::shared_ptr<GraphNode> find_node_at(const Point& p, double flatness = DisplayList::HIT_FLATNESS) const;
+    std::shared_ptr<GraphEdge> find_edge_at(const Point& p, double flatness = DisplayList::HIT_FLATNESS) const;
+    // Elements whose bounds, widened by their hit margin, intersect area,
+    // in drawing order. Does not decode deferred shapes.
+    std::vector<std::shared_ptr<GraphNode>> find_nodes_in(const BoundingBox& area) const;
+    std::vector<std::shared_ptr<GraphEdge>> find_edges_in(const BoundingBox& area) const;
     
     void clear_highlights();
     void highlight_node(const std::string& node_id);
@@ -81,8 +146,23 @@ public:
 private:
     std::vector<std::shared_ptr<GraphNode>> nodes_;
     std::vector<std::shared_ptr<GraphEdge>> edges_;
-    std::vector<std::shared_ptr<Shape>> background_shapes_;
+    std::vector<OpRange> background_;
+    std::shared_ptr<PenPool> pens_;
+    std::shared_ptr<PrototypePool> prototypes_;
+    std::shared_ptr<DisplayList> display_list_;
+    std::shared_ptr<ShapeCache> shape_cache_;
+    mutable std::shared_ptr<const SpatialIndex> node_index_;
+    mutable std::shared_ptr<const SpatialIndex> edge_index_;
+    // Union of everything added; empty until something is
+    mutable BoundingBox bounds_;
+    mutable bool has_bounds_;
+    mutable bool bounds_dirty_;
+    bool has_deferred_shapes_;
     std::map<std::string, std::shared_ptr<GraphNode>> node_map_;
+    
+    void include_bounds(const BoundingBox& box) const;
+    const SpatialIndex& node_index() const;
+    const SpatialIndex& edge_index() const;
 };
 
 } // namespace xdot
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "pen.h"
+#include <cstddef>
+#include <deque>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace xdot_cpp {
+namespace xdot {
+
+// Distinct pens of a graph. Shapes refer to their pen's entry instead of
+// carrying a copy; equal pens share one entry, so a renderer can build its
+// toolkit pen and brush objects once per entry. Entries never move, so
+// the pointers intern() returns are read without locking. intern() may be
+// called from several threads at once, also while other threads read
+// entries.
+class PenPool {
+public:
+    PenPool();
+    PenPool(const PenPool&) = delete;
+    PenPool& operator=(const PenPool&) = delete;
+
+    // Entry equal to pen, added if there is none yet
+    const Pen* intern(const Pen& pen);
+    // Entry 0, for shapes that draw without a pen
+    const Pen* default_pen() const { return default_pen_; }
+
+    size_t size() const {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return pens_.size();
+    }
+
+private:
+    std::deque<Pen> pens_;
+    // Pen hash to the entries with that hash
+    std::unordered_multimap<size_t, const Pen*> index_;
+    mutable std::shared_mutex mutex_;
+    const Pen* default_pen_;
+};
+
+} // namespace xdot
+} // namespace xdot_cpp
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "elements.h"
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace xdot_cpp {
+namespace xdot {
+
+// Position of a prototype in a PrototypePool
+using PrototypeIndex = uint32_t;
+
+// Distinct polygon outlines of a graph up to position and rotation.
+// Graphviz repeats the same arrowheads and node outlines all over a
+// layout; polygons keep one canonical copy of their points here and a
+// Placement instead of their own points. Canonical points are snapped to
+// a grid of GRID units, so placed points are within GRID of the input.
+// Entries never move. intern() may be called from several threads at
+// once, also while other threads read entries.
+class PrototypePool {
+public:
+    // A power of two, so snapped coordinates are exact
+    static constexpr double GRID = 1.0 / 128.0;
+
+    PrototypePool() = default;
+    PrototypePool(const PrototypePool&) = delete;
+    PrototypePool& operator=(const PrototypePool&) = delete;
+
+    // Index of the prototype congruent to points, adding it if there is
+    // none yet; placement is set to map the prototype onto points
+    PrototypeIndex intern(const Point* points, size_t count, Placement& placement);
+
+    const std::vector<Point>& operator[](PrototypeIndex index) const {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return prototypes_[index];
+    }
+    size_t size() const {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return prototypes_.size();
+    }
+
+private:
+    std::deque<std::vector<Point>> prototypes_;
+    // Prototype hash to the indices of the prototypes with that hash
+    std::unordered_multimap<size_t, PrototypeIndex> index_;
+    mutable std::shared_mutex mutex_;
+};
+
+} // namespace xdot
+} // namespace xdot_cpp
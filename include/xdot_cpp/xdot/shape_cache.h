@@ -0,0 +1,106 @@
+#pragma once
+
+#include "display_list.h"
+#include "draw_attributes.h"
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace xdot_cpp {
+namespace xdot {
+
+class ShapeCache;
+
+// Undecoded drawing attributes of a node or edge, with the bounds of the
+// shapes they decode to. The views point into a buffer kept alive by
+// source. Shapes decode into a display list of their own, kept here; with
+// a cache it is subject to its memory budget, without one it is kept once
+// decoded.
+struct DeferredShapes {
+    std::array<std::string_view, DrawAttributes::SHAPE_SLOT_COUNT> draw_attributes;  // in drawing order
+    std::shared_ptr<PenPool> pens;
+    std::shared_ptr<PrototypePool> prototypes;
+    std::shared_ptr<const void> source;
+    std::shared_ptr<ShapeCache> cache;
+    BoundingBox bounds;
+    double hit_margin = 0.0;
+    // Number of operations the attributes decode to
+    uint32_t op_count = 0;
+    
+    DeferredShapes() = default;
+    DeferredShapes(const DeferredShapes&) = delete;
+    DeferredShapes& operator=(const DeferredShapes&) = delete;
+    ~DeferredShapes();
+    
+    // Decodes if the shapes are not in memory. With a cache, the result
+    // may be dropped by the next call for another element.
+    const DisplayList& shapes();
+    bool is_decoded() const { return decoded_ != nullptr; }
+    // Where the shapes are in their list
+    OpRange ops() const { return {0, op_count}; }
+    
+    std::unique_ptr<DisplayList> decode() const;
+    
+private:
+    friend class ShapeCache;
+    
+    std::unique_ptr<DisplayList> decoded_;
+    size_t bytes_ = 0;
+    // Cache recency list, most recently used first
+    DeferredShapes* newer_ = nullptr;
+    DeferredShapes* older_ = nullptr;
+};
+
+// Decoded shapes of deferred elements within a memory budget. When the
+// shapes in memory exceed it, those of the least recently used elements
+// are dropped and decoded again from their attributes on next use. Lists
+// grow after they are handed out, as curves are flattened for drawing and
+// hit tests; the last list handed out is measured again by the next
+// shapes() or update(). Not thread-safe; use from the thread that draws
+// and hit-tests.
+class ShapeCache {
+public:
+    struct Stats {
+        size_t hits = 0;       // shapes were in memory
+        size_t misses = 0;     // shapes had to be decoded
+        size_t evictions = 0;  // elements whose shapes were dropped
+        size_t bytes = 0;      // estimated size of the shapes in memory
+        size_t elements = 0;   // elements with shapes in memory
+    };
+    
+    // budget == 0 keeps everything
+    explicit ShapeCache(size_t budget = 0) : budget_(budget) {}
+    ShapeCache(const ShapeCache&) = delete;
+    ShapeCache& operator=(const ShapeCache&) = delete;
+    
+    size_t budget() const { return budget_; }
+    // Evicts right away if the shapes in memory exceed the new budget
+    void set_budget(size_t budget);
+    
+    const Stats& stats() const { return stats_; }
+    void reset_counters();
+    
+    const DisplayList& shapes(DeferredShapes& deferred);
+    void remove(DeferredShapes& deferred);
+    // Measures the last list handed out again and trims to the budget;
+    // call when done drawing or hit-testing
+    void update();
+    
+private:
+    size_t budget_;
+    Stats stats_;
+    DeferredShapes* newest_ = nullptr;
+    DeferredShapes* oldest_ = nullptr;
+    
+    void link(DeferredShapes& deferred);
+    void unlink(DeferredShapes& deferred);
+    void evict(DeferredShapes& deferred);
+    void measure(DeferredShapes& deferred);
+    // Evicts the oldest entries other than keep until within budget
+    void trim(const DeferredShapes* keep);
+};
+
+} // namespace xdot
+} // namespace xdot_cpp
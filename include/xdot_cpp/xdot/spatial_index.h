@@ -0,0 +1,67 @@
+#pragma once
+
+#include "elements.h"
+#include "geometry.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace xdot_cpp {
+namespace xdot {
+
+// Static R-tree over boxes tagged with ids, bulk loaded with
+// Sort-Tile-Recursive packing: entries are sorted into vertical slices by
+// x, each slice by y, and runs of NODE_CAPACITY become nodes; the nodes
+// are packed the same way level by level. Point and range queries visit
+// O(log n) nodes plus the ones that overlap the query, testing all
+// children of a node in one batch. The index is immutable, so concurrent
+// queries are safe.
+class SpatialIndex {
+public:
+    struct Entry {
+        BoundingBox box;
+        uint32_t id;
+    };
+
+    static constexpr size_t NODE_CAPACITY = 16;
+
+    SpatialIndex() = default;
+    explicit SpatialIndex(std::vector<Entry> entries);
+
+    size_t size() const { return ids_.size(); }
+
+    // Appends the ids of the boxes containing p, in no particular order
+    void query(const Point& p, std::vector<uint32_t>& ids) const;
+    // Appends the ids of the boxes intersecting area, in no particular order
+    void query(const BoundingBox& area, std::vector<uint32_t>& ids) const;
+
+private:
+    // Boxes one array per coordinate, for the batch kernels in geometry.h
+    struct Boxes {
+        std::vector<Coord> x1, y1, x2, y2;
+
+        void push_back(const BoundingBox& box);
+        geometry::BoxArrays arrays() const { return {x1.data(), y1.data(), x2.data(), y2.data()}; }
+    };
+
+    struct Level {
+        Boxes boxes;
+        // Children of node i are [first[i], first[i] + count[i]) of the
+        // level below, or of the entries for levels_[0]
+        std::vector<uint32_t> first;
+        std::vector<uint8_t> count;
+    };
+
+    Boxes entry_boxes_;
+    std::vector<uint32_t> ids_;
+    // levels_[0] groups entries, levels_[i] groups the nodes of
+    // levels_[i - 1]; the last level holds the roots
+    std::vector<Level> levels_;
+
+    // mask(boxes, first, count) selects the boxes to descend into
+    template <typename Mask>
+    void search(const Mask& mask, std::vector<uint32_t>& ids) const;
+};
+
+} // namespace xdot
+} // namespace xdot_cpp
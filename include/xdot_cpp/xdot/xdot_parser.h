@@ -1,40 +1,82 @@
 #pragma once
 
-#include "elements.h"
+#include "display_list.h"
 #include "pen.h"
+#include "draw_attributes.h"
 #include "../dot/parser.h"
+#include "../dot/push_parser.h"
+#include "../dot/visitor.h"
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <map>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <vector>
 #include <memory>
 
 namespace xdot_cpp {
 namespace xdot {
 
+// Decodes one xdot drawing attribute (_draw_, _ldraw_, ...) into display
+// list operations. The parser borrows xdot_data, which must outlive
+// parse().
 class XDotAttrParser {
 public:
-    XDotAttrParser(const std::string& xdot_data, bool broken_backslashes = false);
+    explicit XDotAttrParser(std::string_view xdot_data, bool broken_backslashes = false);
     
-    std::vector<std::shared_ptr<Shape>> parse();
+    // Appends the shapes to list, interning pens and polygon outlines into
+    // its pools. Returns the operations appended.
+    OpRange parse(DisplayList& list);
+    // Bounding box of the operations parse() would append, without
+    // decoding them or allocating. Returns their number. hit_margin is how
+    // far outside bounds DisplayList::contains() can still report a hit.
+    size_t scan_bounds(BoundingBox& bounds, double& hit_margin);
     
 private:
-    std::string data_;
+    using Handler = void (XDotAttrParser::*)();
+    
+    std::string_view data_;
     size_t pos_;
+    bool broken_backslashes_;
+    // parse() target
+    DisplayList* list_;
     Pen current_pen_;
+    // Pool entry of current_pen_, interned when a shape first needs it
+    const Pen* current_entry_;
+    bool pen_changed_;
+    // Text operands that needed backslash fix-up
+    std::string text_;
+    
+    // scan_bounds() state
+    bool bounds_only_;
+    size_t shape_count_;
+    BoundingBox bounds_;
+    double hit_margin_;
+    std::vector<Point> scratch_points_;
+    
+    // Handler per opcode byte, nullptr for bytes that are not operations
+    static const Handler* opcode_table();
     
     bool has_more() const;
     char current_char() const;
     void advance();
     void skip_whitespace();
     
-    std::string read_code();
     int read_int();
     double read_float();
     Point read_point();
-    std::string read_text();
-    std::vector<Point> read_polygon();
+    // Valid until the next read_text()
+    std::string_view read_text();
+    void read_polygon(std::vector<Point>& points);
     Color read_color();
     
     Point transform(double x, double y) const;
+    const Pen* pen_entry();
+    void add_bounds(const BoundingBox& box, double hit_margin = 0.0);
+    void run();
     
     void handle_ellipse();
     void handle_polygon();
@@ -46,21 +88,139 @@ private:
     void handle_color();
     void handle_fill_color();
     void handle_font();
-    
-    std::vector<std::shared_ptr<Shape>> shapes_;
 };
 
+class GraphElement;
+
+// Builds the scene of a parsed graph. With more than one worker the
+// drawing attributes of nodes and edges are decoded on that many threads;
+// the scene is the same as with one, elements keep their document order.
+// workers == 0 uses every hardware thread.
+//
+// With lazy decoding, parse() only scans each node and edge for the bounds
+// of its shapes; the shapes are decoded from the graph's attribute values
+// when first drawn or hit-tested, and the elements keep the graph alive.
 class XDotParser {
 public:
-    explicit XDotParser(std::shared_ptr<dot::Graph> graph);
+    explicit XDotParser(std::shared_ptr<dot::Graph> graph, size_t workers = 1);
+    
+    void set_lazy(bool lazy) { lazy_ = lazy; }
     
-    std::shared_ptr<class GraphElement> parse();
+    std::shared_ptr<GraphElement> parse();
     
 private:
     std::shared_ptr<dot::Graph> graph_;
+    size_t workers_;
+    bool lazy_;
+    
+};
+
+// Builds the scene straight from parser events in one pass, without a
+// dot::Graph in between. Use with dot::visit() or, through a
+// dot::VisitorAdapter, with DotPushParser. Node and edge defaults are
+// applied; nodes are expected to be stated once, as in Graphviz output.
+class XDotSceneBuilder : public dot::DotVisitor {
+public:
+    XDotSceneBuilder();
+    
+    std::shared_ptr<GraphElement> graph_element() const { return graph_element_; }
+    
+    void on_subgraph_begin(std::string_view id) override;
+    void on_subgraph_end() override;
+    void on_node(std::string_view id) override;
+    void on_edge(std::string_view source, std::string_view target) override;
+    void on_attributes(dot::TokenType kind) override;
+    void on_attribute(std::string_view name, std::string_view value) override;
+    void on_statement_end() override;
+    
+protected:
+    // Called for every node and edge statement with defaults applied; the
+    // views are valid until they return. Both decode the shapes and add
+    // the element to the scene right away.
+    virtual void add_node(std::string_view id, const DrawAttributes& draw);
+    virtual void add_edge(std::string_view source, std::string_view target, const DrawAttributes& draw);
+    
+private:
+    // Node and edge defaults outlive the statement that set them, so
+    // their drawing attributes are copied
+    using StoredAttributes = std::array<std::string, DrawAttributes::SLOT_COUNT>;
+    
+    struct Scope {
+        StoredAttributes node;
+        StoredAttributes edge;
+    };
+    
+    std::shared_ptr<GraphElement> graph_element_;
+    std::vector<Scope> scopes_;
+    
+    // Statement being reported
+    dot::TokenType kind_;
+    bool is_defaults_;
+    std::string_view id_;
+    std::string_view target_;
+    DrawAttributes current_;
+    
+    void begin_statement(dot::TokenType kind);
+    static void load(const StoredAttributes& stored, DrawAttributes& draw);
+    static void store(const DrawAttributes& draw, StoredAttributes& stored);
+};
+
+// Pipelined load of a Graphviz xdot stream. feed() lexes and parses the
+// bytes it is given on the calling thread and copies the drawing
+// attributes of the nodes and edges completed so far into a batch, which
+// worker threads decode while more input arrives. publish() adds the
+// batches decoded so far to graph_element() in document order, so a view
+// can show a layout before dot has finished writing it. workers == 0 uses
+// every hardware thread but the calling one. Apart from the workers, use
+// from one thread.
+class SceneLoader {
+public:
+    explicit SceneLoader(size_t workers = 0);
+    ~SceneLoader();
+    
+    SceneLoader(const SceneLoader&) = delete;
+    SceneLoader& operator=(const SceneLoader&) = delete;
+    
+    // Graph and cluster backgrounds are added as soon as they are parsed,
+    // nodes and edges by publish()
+    const std::shared_ptr<GraphElement>& graph_element() const { return graph_element_; }
+    
+    void feed(const char* data, size_t size);
+    // Elements added since the last call. Rethrows what a worker threw
+    // while decoding.
+    size_t publish();
+    // Checks that the graph was closed, waits for the remaining batches and
+    // publishes them
+    std::shared_ptr<GraphElement> finish();
+    
+private:
+    struct Batch;
+    class Collector;
+    
+    std::unique_ptr<Collector> collector_;
+    std::shared_ptr<GraphElement> graph_element_;
+    dot::VisitorAdapter adapter_;
+    dot::DotPushParser parser_;
+    // Statements parsed since the last batch was queued
+    std::unique_ptr<Batch> pending_;
+    size_t next_sequence_;
+    size_t next_publish_;
+    
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable queued_;
+    std::condition_variable decoded_;
+    std::deque<std::unique_ptr<Batch>> queue_;
+    // Decoded batches by sequence number, waiting for their turn
+    std::map<size_t, std::unique_ptr<Batch>> done_;
+    // First exception a worker threw, for publish() to rethrow
+    std::exception_ptr error_;
+    bool stopping_;
     
-    std::vector<std::shared_ptr<Shape>> parse_xdot_attr(const std::string& xdot_data);
-    std::string get_attribute_value(const dot::AttributeList& attrs, const std::string& name, const std::string& default_value = "");
+    void collect(std::string_view id, std::string_view target, bool is_edge, const DrawAttributes& draw);
+    void submit();
+    void work();
+    void decode(Batch& batch) const;
 };
 
 } // namespace xdot
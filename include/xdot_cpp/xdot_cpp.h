@@ -10,11 +10,24 @@
  */
 
 #include "dot/lexer.h"
+#include "dot/symbol_table.h"
+#include "dot/node_table.h"
 #include "dot/parser.h"
+#include "dot/push_parser.h"
+#include "dot/parallel_parser.h"
+#include "dot/visitor.h"
+#include "dot/arena_ast.h"
 #include "xdot/xdot_parser.h"
 #include "xdot/pen.h"
+#include "xdot/pen_pool.h"
+#include "xdot/prototype_pool.h"
 #include "xdot/color.h"
 #include "xdot/elements.h"
+#include "xdot/geometry.h"
+#include "xdot/display_list.h"
+#include "xdot/shape_cache.h"
+#include "xdot/spatial_index.h"
+#include "xdot/draw_attributes.h"
 #include "xdot/graph.h"
 
 namespace xdot_cpp {
@@ -31,6 +31,31 @@ for test in "${tests[@]}"; do
     fi
 done
 
+echo
+
+# Consistency checks (built with XDOT_CPP_BUILD_CHECKS)
+checks=(
+    "xdot_push_parser_check:push parser at every chunk boundary"
+    "xdot_parallel_parser_check:parallel parser against the sequential one"
+    "xdot_arena_ast_check:arena AST against the sequential parser"
+    "xdot_geometry_kernels_check:geometry kernel sets against the scalar one"
+    "xdot_shape_cache_check:shape cache budget and lazy hit tests"
+)
+
+for check in "${checks[@]}"; do
+    program="./build/${check%%:*}"
+    desc="${check##*:}"
+    [ -x "$program" ] || continue
+    
+    echo -n "Checking $desc... "
+    
+    if "$program" tests/*.dot examples/*.dot >/dev/null 2>&1; then
+        echo "✓"
+    else
+        echo "❌ (run $program tests/*.dot examples/*.dot for details)"
+    fi
+done
+
 echo
 echo "Note: Unicode test may show parsing errors due to special characters."
 echo "This is a known limitation that could be improved in future versions."
\ No newline at end of file
@@ -0,0 +1,185 @@
+#include "xdot_cpp/dot/arena_ast.h"
+#include <algorithm>
+#include <cstring>
+
+namespace xdot_cpp {
+namespace dot {
+
+namespace {
+
+// First arena block; the resource grows geometrically from here
+constexpr size_t INITIAL_ARENA_SIZE = 64 * 1024;
+
+} // namespace
+
+// ArenaGraph implementation
+ArenaGraph::ArenaGraph()
+    : type(Graph::DIGRAPH), strict(false), arena_(INITIAL_ARENA_SIZE), arena_bytes_(0) {}
+
+std::string_view ArenaGraph::store(std::string_view text) {
+    if (text.empty()) {
+        return std::string_view();
+    }
+
+    char* copy = static_cast<char*>(arena_.allocate(text.length(), 1));
+    std::memcpy(copy, text.data(), text.length());
+    arena_bytes_ += text.length();
+    return std::string_view(copy, text.length());
+}
+
+// ArenaAstBuilder implementation
+ArenaAstBuilder::ArenaAstBuilder() : graph_(std::make_shared<ArenaGraph>()), depth_(0) {}
+
+void ArenaAstBuilder::begin_graph(Graph::Type type, bool strict, std::string_view id) {
+    graph_->type = type;
+    graph_->strict = strict;
+    graph_->id = graph_->store(id);
+    open_scope();
+}
+
+void ArenaAstBuilder::end_graph() {
+    graph_->root = close_scope();
+}
+
+void ArenaAstBuilder::begin_subgraph(std::string_view id) {
+    uint32_t index = static_cast<uint32_t>(graph_->subgraphs.size());
+    graph_->subgraphs.push_back({graph_->store(id), ArenaScope()});
+    scopes_[depth_ - 1].subgraphs.push_back(index);
+    open_scope();
+}
+
+void ArenaAstBuilder::end_subgraph() {
+    // The subgraph opened last is the last one still without a scope
+    uint32_t index = scopes_[depth_ - 2].subgraphs.back();
+    graph_->subgraphs[index].scope = close_scope();
+}
+
+void ArenaAstBuilder::add_node(std::string_view id, const AttributeViews& attributes) {
+    OpenScope& scope = scopes_[depth_ - 1];
+    uint32_t index = static_cast<uint32_t>(graph_->nodes.size());
+    graph_->nodes.push_back({graph_->store(id), store_attributes(attributes), scope.node_defaults, next_sequence()});
+    scope.nodes.push_back(index);
+}
+
+void ArenaAstBuilder::add_edge(std::string_view source, std::string_view target,
+                               const AttributeViews& attributes) {
+    OpenScope& scope = scopes_[depth_ - 1];
+    uint32_t index = static_cast<uint32_t>(graph_->edges.size());
+    graph_->edges.push_back({graph_->store(source), graph_->store(target), store_attributes(attributes),
+                             scope.edge_defaults, scope.node_defaults, next_sequence()});
+    scope.edges.push_back(index);
+}
+
+void ArenaAstBuilder::add_attributes(TokenType kind, const AttributeViews& attributes) {
+    OpenScope& scope = scopes_[depth_ - 1];
+    if (kind == TokenType::NODE) {
+        scope.node_defaults = merge_defaults(scope.node_defaults, attributes);
+    } else if (kind == TokenType::EDGE) {
+        scope.edge_defaults = merge_defaults(scope.edge_defaults, attributes);
+    } else {
+        append_attributes(scope.attributes, attributes);
+    }
+}
+
+void ArenaAstBuilder::open_scope() {
+    if (depth_ == scopes_.size()) {
+        scopes_.emplace_back();
+    }
+
+    OpenScope& scope = scopes_[depth_++];
+    scope.attributes.clear();
+    // Subgraphs start out with the defaults of the enclosing body
+    scope.node_defaults = depth_ > 1 ? scopes_[depth_ - 2].node_defaults : NO_DEFAULTS;
+    scope.edge_defaults = depth_ > 1 ? scopes_[depth_ - 2].edge_defaults : NO_DEFAULTS;
+    scope.nodes.clear();
+    scope.edges.clear();
+    scope.subgraphs.clear();
+}
+
+ArenaScope ArenaAstBuilder::close_scope() {
+    const OpenScope& open = scopes_[--depth_];
+
+    ArenaScope scope;
+    scope.attributes = flush_attributes(open.attributes);
+    scope.node_defaults = open.node_defaults;
+    scope.edge_defaults = open.edge_defaults;
+    scope.nodes = flush_children(open.nodes);
+    scope.edges = flush_children(open.edges);
+    scope.subgraphs = flush_children(open.subgraphs);
+    return scope;
+}
+
+IndexRange ArenaAstBuilder::store_attributes(const AttributeViews& attributes) {
+    IndexRange range(static_cast<uint32_t>(graph_->attributes.size()),
+                     static_cast<uint32_t>(attributes.size()));
+    for (const auto& attr : attributes) {
+        graph_->attributes.push_back({graph_->store(attr.name), graph_->store(attr.value)});
+    }
+    return range;
+}
+
+void ArenaAstBuilder::append_attributes(std::vector<ArenaAttribute>& target,
+                                        const AttributeViews& attributes) {
+    for (const auto& attr : attributes) {
+        target.push_back({graph_->store(attr.name), graph_->store(attr.value)});
+    }
+}
+
+DefaultSet ArenaAstBuilder::merge_defaults(DefaultSet defaults, const AttributeViews& attributes) {
+    // Elements declared so far keep referring to the old set
+    std::vector<ArenaAttribute>& all = graph_->attributes;
+    IndexRange previous = defaults == NO_DEFAULTS ? IndexRange() : graph_->default_sets[defaults];
+    IndexRange merged(static_cast<uint32_t>(all.size()), previous.count);
+    all.reserve(all.size() + previous.count + attributes.size());
+    for (uint32_t i = 0; i < previous.count; i++) {
+        all.push_back(all[previous.begin + i]);
+    }
+
+    for (const auto& attr : attributes) {
+        auto first = all.begin() + merged.begin;
+        auto it = std::find_if(first, all.end(), [&](const ArenaAttribute& existing) {
+            return existing.name == attr.name;
+        });
+        if (it != all.end()) {
+            it->value = graph_->store(attr.value);
+        } else {
+            all.push_back({graph_->store(attr.name), graph_->store(attr.value)});
+            merged.count++;
+        }
+    }
+
+    graph_->default_sets.push_back(merged);
+    return static_cast<DefaultSet>(graph_->default_sets.size() - 1);
+}
+
+uint32_t ArenaAstBuilder::next_sequence() const {
+    return static_cast<uint32_t>(graph_->nodes.size() + graph_->edges.size());
+}
+
+IndexRange ArenaAstBuilder::flush_attributes(const std::vector<ArenaAttribute>& source) {
+    IndexRange range(static_cast<uint32_t>(graph_->attributes.size()),
+                     static_cast<uint32_t>(source.size()));
+    graph_->attributes.insert(graph_->attributes.end(), source.begin(), source.end());
+    return range;
+}
+
+IndexRange ArenaAstBuilder::flush_children(const std::vector<uint32_t>& source) {
+    IndexRange range(static_cast<uint32_t>(graph_->children.size()),
+                     static_cast<uint32_t>(source.size()));
+    graph_->children.insert(graph_->children.end(), source.begin(), source.end());
+    return range;
+}
+
+std::shared_ptr<ArenaGraph> parse_arena(const std::string& text) {
+    return parse_arena(text.data(), text.length());
+}
+
+std::shared_ptr<ArenaGraph> parse_arena(const char* data, size_t size) {
+    DotParser parser(data, size);
+    ArenaAstBuilder builder;
+    parser.parse(builder);
+    return builder.graph();
+}
+
+} // namespace dot
+} // namespace xdot_cpp
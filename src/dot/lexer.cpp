@@ -1,6 +1,7 @@
 #include "xdot_cpp/dot/lexer.h"
-#include <cctype>
-#include <unordered_map>
+#include "xdot_cpp/dot/scanner.h"
+#include <algorithm>
+#include <cstring>
 
 namespace xdot_cpp {
 namespace dot {
@@ -8,8 +9,14 @@ namespace dot {
 ParseError::ParseError(const std::string& message, size_t line, size_t column)
     : std::runtime_error(message), line_(line), column_(column) {}
 
+ParseError::ParseError(const std::string& message, const SourceLocation& location)
+    : ParseError(message, location.line, location.column) {}
+
 DotLexer::DotLexer(const std::string& text)
-    : text_(text), pos_(0), line_(1), column_(1), has_peeked_(false) {}
+    : owned_text_(text), text_(owned_text_), pos_(0), has_peeked_(false) {}
+
+DotLexer::DotLexer(const char* data, size_t size)
+    : text_(data, size), pos_(0), has_peeked_(false) {}
 
 Token DotLexer::next_token() {
     if (has_peeked_) {
@@ -20,42 +27,41 @@ Token DotLexer::next_token() {
     skip_whitespace();
     
     if (pos_ >= text_.length()) {
-        return Token(TokenType::EOF_TOKEN, "", line_, column_);
+        return Token(TokenType::EOF_TOKEN, "", pos_);
     }
     
     char c = current_char();
-    size_t token_line = line_;
-    size_t token_column = column_;
+    size_t token_offset = pos_;
     
     // Single character tokens
     switch (c) {
         case '[':
             advance();
-            return Token(TokenType::LSQUARE, "[", token_line, token_column);
+            return Token(TokenType::LSQUARE, "[", token_offset);
         case ']':
             advance();
-            return Token(TokenType::RSQUARE, "]", token_line, token_column);
+            return Token(TokenType::RSQUARE, "]", token_offset);
         case '{':
             advance();
-            return Token(TokenType::LCURLY, "{", token_line, token_column);
+            return Token(TokenType::LCURLY, "{", token_offset);
         case '}':
             advance();
-            return Token(TokenType::RCURLY, "}", token_line, token_column);
+            return Token(TokenType::RCURLY, "}", token_offset);
         case ',':
             advance();
-            return Token(TokenType::COMMA, ",", token_line, token_column);
+            return Token(TokenType::COMMA, ",", token_offset);
         case ':':
             advance();
-            return Token(TokenType::COLON, ":", token_line, token_column);
+            return Token(TokenType::COLON, ":", token_offset);
         case ';':
             advance();
-            return Token(TokenType::SEMI, ";", token_line, token_column);
+            return Token(TokenType::SEMI, ";", token_offset);
         case '=':
             advance();
-            return Token(TokenType::EQUAL, "=", token_line, token_column);
+            return Token(TokenType::EQUAL, "=", token_offset);
         case '+':
             advance();
-            return Token(TokenType::PLUS, "+", token_line, token_column);
+            return Token(TokenType::PLUS, "+", token_offset);
     }
     
     // Edge operators
@@ -63,11 +69,11 @@ Token DotLexer::next_token() {
         if (peek_char() == '>') {
             advance();
             advance();
-            return Token(TokenType::EDGE_OP, "->", token_line, token_column);
+            return Token(TokenType::EDGE_OP, "->", token_offset);
         } else if (peek_char() == '-') {
             advance();
             advance();
-            return Token(TokenType::EDGE_OP, "--", token_line, token_column);
+            return Token(TokenType::EDGE_OP, "--", token_offset);
         }
     }
     
@@ -81,18 +87,19 @@ Token DotLexer::next_token() {
         return read_html_string();
     }
     
-    // Numbers
-    if (is_digit(c) || (c == '.' && is_digit(peek_char()))) {
+    // Numbers (DOT numerals may carry a leading minus sign)
+    if (is_digit(c) || (c == '.' && is_digit(peek_char())) ||
+        (c == '-' && (is_digit(peek_char()) || (peek_char() == '.' && is_digit(peek_char(2)))))) {
         return read_number();
     }
     
     // Identifiers and keywords
-    if (is_alpha(c) || c == '_') {
+    if (is_alpha(c)) {
         return read_identifier();
     }
     
     // Unknown character
-    throw ParseError("Unexpected character: " + std::string(1, c), line_, column_);
+    throw ParseError("Unexpected character: " + std::string(1, c), location(pos_));
 }
 
 Token DotLexer::peek_token() {
@@ -124,84 +131,115 @@ char DotLexer::peek_char(size_t offset) const {
 
 void DotLexer::advance() {
     if (pos_ < text_.length()) {
-        if (text_[pos_] == '\n') {
-            line_++;
-            column_ = 1;
-        } else {
-            column_++;
-        }
         pos_++;
     }
 }
 
+SourceLocation DotLexer::location(size_t offset) const {
+    // Line starts are only indexed the first time a position is asked for
+    if (line_starts_.empty()) {
+        line_starts_.push_back(0);
+        const char* begin = text_.data();
+        const char* end = begin + text_.length();
+        for (const char* p = begin; p < end; p++) {
+            p = static_cast<const char*>(std::memchr(p, '\n', end - p));
+            if (!p) break;
+            line_starts_.push_back(static_cast<size_t>(p - begin) + 1);
+        }
+    }
+    
+    auto it = std::upper_bound(line_starts_.begin(), line_starts_.end(), offset);
+    size_t line = static_cast<size_t>(it - line_starts_.begin());
+    return SourceLocation(line, offset - *(it - 1) + 1);
+}
+
 void DotLexer::skip_whitespace() {
-    while (pos_ < text_.length() && is_whitespace(current_char())) {
-        if (current_char() == '/' && peek_char() == '/') {
+    while (pos_ < text_.length()) {
+        char c = current_char();
+        if (is_whitespace(c)) {
+            pos_ = scan::skip_whitespace(text_.data(), pos_, text_.length());
+        } else if (c == '/' && peek_char() == '/') {
             skip_comment();
-        } else if (current_char() == '/' && peek_char() == '*') {
+        } else if (c == '/' && peek_char() == '*') {
             // Skip C-style comments
-            advance(); // skip '/'
-            advance(); // skip '*'
-            while (pos_ < text_.length() - 1) {
-                if (current_char() == '*' && peek_char() == '/') {
-                    advance(); // skip '*'
-                    advance(); // skip '/'
-                    break;
-                }
-                advance();
-            }
-        } else if (current_char() == '#') {
+            size_t close = text_.find("*/", pos_ + 2);
+            pos_ = close == std::string_view::npos ? text_.length() : close + 2;
+        } else if (c == '#') {
             skip_comment();
         } else {
-            advance();
+            break;
         }
     }
 }
 
 void DotLexer::skip_comment() {
-    while (pos_ < text_.length() && current_char() != '\n') {
-        advance();
-    }
+    size_t newline = text_.find('\n', pos_);
+    pos_ = newline == std::string_view::npos ? text_.length() : newline;
 }
 
 Token DotLexer::read_string() {
-    size_t token_line = line_;
-    size_t token_column = column_;
-    std::string value;
+    size_t token_offset = pos_;
     
     advance(); // skip opening quote
+    size_t start = pos_;
+    bool has_escapes = false;
+    
+    size_t end = start;
+    
+    for (;;) {
+        end = scan::skip_string_body(text_.data(), end, text_.length());
+        if (end >= text_.length() || text_[end] == '"') break;
+        // Backslash: skip it together with the escaped character
+        has_escapes = true;
+        end += 2;
+    }
+    
+    if (end >= text_.length()) {
+        throw ParseError("Unterminated string literal", location(token_offset));
+    }
     
-    while (pos_ < text_.length() && current_char() != '"') {
-        if (current_char() == '\\' && peek_char() != '\0') {
-            advance(); // skip backslash
-            char escaped = current_char();
+    std::string_view raw = text_.substr(start, end - start);
+    pos_ = end + 1; // skip body and closing quote
+    
+    if (!has_escapes) {
+        return Token(TokenType::STR_ID, raw, token_offset);
+    }
+    
+    // Only strings that actually contain backslashes get a private copy
+    std::string value;
+    value.reserve(raw.length());
+    for (size_t i = 0; i < raw.length(); i++) {
+        if (raw[i] == '\\' && i + 1 < raw.length()) {
+            char escaped = raw[++i];
             switch (escaped) {
                 case 'n': value += '\n'; break;
                 case 't': value += '\t'; break;
                 case 'r': value += '\r'; break;
                 case '\\': value += '\\'; break;
                 case '"': value += '"'; break;
+                case '\n': break; // line continuation, as written by Graphviz
+                case '\r':
+                    // CRLF line continuation; a lone CR is kept as is
+                    if (i + 1 < raw.length() && raw[i + 1] == '\n') {
+                        i++;
+                    } else {
+                        value += escaped;
+                    }
+                    break;
                 default: value += escaped; break;
             }
-            advance();
         } else {
-            value += current_char();
-            advance();
+            value += raw[i];
         }
     }
     
-    if (pos_ >= text_.length()) {
-        throw ParseError("Unterminated string literal", token_line, token_column);
-    }
-    
-    advance(); // skip closing quote
-    return Token(TokenType::STR_ID, value, token_line, token_column);
+    unescaped_.push_back(std::move(value));
+    return Token(TokenType::STR_ID, unescaped_.back(), token_offset);
 }
 
 Token DotLexer::read_html_string() {
-    size_t token_line = line_;
-    size_t token_column = column_;
-    std::string value;
+    size_t token_offset = pos_;
+    size_t start = pos_;
     int depth = 0;
     
     do {
@@ -210,95 +248,75 @@ Token DotLexer::read_html_string() {
         } else if (current_char() == '>') {
             depth--;
         }
-        value += current_char();
         advance();
     } while (pos_ < text_.length() && depth > 0);
     
     if (depth > 0) {
-        throw ParseError("Unterminated HTML string", token_line, token_column);
+        throw ParseError("Unterminated HTML string", location(token_offset));
     }
     
-    return Token(TokenType::HTML_ID, value, token_line, token_column);
+    return Token(TokenType::HTML_ID, text_.substr(start, pos_ - start), token_offset);
 }
 
 Token DotLexer::read_identifier() {
-    size_t token_line = line_;
-    size_t token_column = column_;
-    std::string value;
-    
-    while (pos_ < text_.length() && (is_alnum(current_char()) || current_char() == '_')) {
-        value += current_char();
-        advance();
-    }
+    size_t token_offset = pos_;
+    size_t start = pos_;
     
-    // Check if it's a keyword
-    static const std::unordered_map<std::string, TokenType> keywords = {
-        {"strict", TokenType::STRICT},
-        {"graph", TokenType::GRAPH},
-        {"digraph", TokenType::DIGRAPH},
-        {"node", TokenType::NODE},
-        {"edge", TokenType::EDGE},
-        {"subgraph", TokenType::SUBGRAPH}
-    };
+    pos_ = scan::skip_identifier(text_.data(), pos_, text_.length());
     
-    auto it = keywords.find(value);
-    TokenType type = (it != keywords.end()) ? it->second : TokenType::ID;
-    
-    return Token(type, value, token_line, token_column);
+    std::string_view value = text_.substr(start, pos_ - start);
+    return Token(lookup_keyword(value), value, token_offset);
 }
 
 Token DotLexer::read_number() {
-    size_t token_line = line_;
-    size_t token_column = column_;
-    std::string value;
+    size_t token_offset = pos_;
+    size_t start = pos_;
+    
+    if (current_char() == '-') {
+        advance();
+    }
     
     // Read integer part
     while (pos_ < text_.length() && is_digit(current_char())) {
-        value += current_char();
         advance();
     }
     
     // Read decimal part
     if (pos_ < text_.length() && current_char() == '.') {
-        value += current_char();
         advance();
         while (pos_ < text_.length() && is_digit(current_char())) {
-            value += current_char();
             advance();
         }
     }
     
     // Read exponent part
     if (pos_ < text_.length() && (current_char() == 'e' || current_char() == 'E')) {
-        value += current_char();
         advance();
         if (pos_ < text_.length() && (current_char() == '+' || current_char() == '-')) {
-            value += current_char();
             advance();
         }
         while (pos_ < text_.length() && is_digit(current_char())) {
-            value += current_char();
             advance();
         }
     }
     
-    return Token(TokenType::ID, value, token_line, token_column);
+    return Token(TokenType::ID, text_.substr(start, pos_ - start), token_offset);
 }
 
 bool DotLexer::is_alpha(char c) const {
-    return std::isalpha(c) || c == '_';
+    return char_classes.is(c, CC_ID_START);
 }
 
 bool DotLexer::is_digit(char c) const {
-    return std::isdigit(c);
+    return char_classes.is(c, CC_DIGIT);
 }
 
 bool DotLexer::is_alnum(char c) const {
-    return std::isalnum(c) || c == '_';
+    return char_classes.is(c, CC_ID_CHAR);
 }
 
 bool DotLexer::is_whitespace(char c) const {
-    return std::isspace(c);
+    return char_classes.is(c, CC_SPACE);
 }
 
 } // namespace dot
@@ -0,0 +1,75 @@
+#include "xdot_cpp/dot/node_table.h"
+
+namespace xdot_cpp {
+namespace dot {
+
+namespace {
+
+constexpr size_t INITIAL_CAPACITY = 64;
+
+} // namespace
+
+NodeTable::NodeTable() : slots_(INITIAL_CAPACITY, Slot{std::string_view(), 0, NO_NODE}), size_(0) {}
+
+NodeIndex NodeTable::find(std::string_view id, uint32_t id_hash) const {
+    return slots_[probe(id, id_hash)].index;
+}
+
+NodeIndex NodeTable::insert(std::string_view id, uint32_t id_hash, bool* inserted) {
+    size_t slot = probe(id, id_hash);
+
+    if (slots_[slot].index == NO_NODE) {
+        // Keep the load factor at or below one half
+        if ((size_ + 1) * 2 > slots_.size()) {
+            grow();
+            slot = probe(id, id_hash);
+        }
+        slots_[slot] = {id, id_hash, static_cast<NodeIndex>(size_++)};
+        if (inserted) *inserted = true;
+    } else if (inserted) {
+        *inserted = false;
+    }
+    return slots_[slot].index;
+}
+
+void NodeTable::clear() {
+    slots_.assign(INITIAL_CAPACITY, Slot{std::string_view(), 0, NO_NODE});
+    size_ = 0;
+}
+
+uint32_t NodeTable::hash(std::string_view id) {
+    // FNV-1a
+    uint32_t h = 2166136261u;
+    for (char c : id) {
+        h = (h ^ static_cast<unsigned char>(c)) * 16777619u;
+    }
+    return h;
+}
+
+size_t NodeTable::probe(std::string_view id, uint32_t h) const {
+    size_t mask = slots_.size() - 1;
+    size_t slot = h & mask;
+    while (slots_[slot].index != NO_NODE &&
+           (slots_[slot].hash != h || slots_[slot].key != id)) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+void NodeTable::grow() {
+    std::vector<Slot> old(slots_.size() * 2, Slot{std::string_view(), 0, NO_NODE});
+    old.swap(slots_);
+
+    size_t mask = slots_.size() - 1;
+    for (const auto& entry : old) {
+        if (entry.index == NO_NODE) continue;
+        size_t slot = entry.hash & mask;
+        while (slots_[slot].index != NO_NODE) {
+            slot = (slot + 1) & mask;
+        }
+        slots_[slot] = entry;
+    }
+}
+
+} // namespace dot
+} // namespace xdot_cpp
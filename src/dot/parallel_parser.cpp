@@ -0,0 +1,302 @@
+#include "xdot_cpp/dot/parallel_parser.h"
+#include "xdot_cpp/dot/statement_splitter.h"
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace xdot_cpp {
+namespace dot {
+
+namespace {
+
+// Slices smaller than this are not worth a thread
+constexpr size_t MIN_SLICE_SIZE = 256 * 1024;
+
+// Records the body statements of one slice. Elements are built completely,
+// with attributes interned into a slice-local symbol table; everything that
+// depends on earlier statements (node identity, defaults, subgraph nesting)
+// is left to AstBuilder when the records are replayed in order.
+class ChunkBuilder : public GraphBuilder {
+public:
+    enum class OpKind : uint8_t { NODE, EDGE, ATTRIBUTES, BEGIN_SUBGRAPH, END_SUBGRAPH };
+
+    struct Op {
+        OpKind kind;
+        TokenType attribute_kind;
+        uint32_t index;            // into nodes, edges or attribute_lists
+        std::string_view id;       // subgraph ID or edge source
+        std::string_view target;
+        uint32_t id_hash;
+        uint32_t target_hash;
+    };
+
+    std::unique_ptr<SymbolTable> symbols = std::make_unique<SymbolTable>();
+    std::vector<Op> ops;
+    std::vector<std::shared_ptr<Node>> nodes;
+    std::vector<std::shared_ptr<Edge>> edges;
+    std::vector<AttributeList> attribute_lists;
+
+    // Only body statements are parsed into a chunk
+    void begin_graph(Graph::Type, bool, std::string_view) override {}
+    void end_graph() override {}
+
+    void begin_subgraph(std::string_view id) override {
+        ops.push_back({OpKind::BEGIN_SUBGRAPH, TokenType::SUBGRAPH, 0, id, {}, 0, 0});
+    }
+
+    void end_subgraph() override {
+        ops.push_back({OpKind::END_SUBGRAPH, TokenType::SUBGRAPH, 0, {}, {}, 0, 0});
+    }
+
+    void add_node(std::string_view id, const AttributeViews& attributes) override {
+        auto node = std::make_shared<Node>(std::string(id));
+        store(node->attributes, attributes);
+        ops.push_back({OpKind::NODE, TokenType::NODE, static_cast<uint32_t>(nodes.size()),
+                       {}, {}, NodeTable::hash(id), 0});
+        nodes.push_back(std::move(node));
+    }
+
+    void add_edge(std::string_view source, std::string_view target,
+                  const AttributeViews& attributes) override {
+        auto edge = std::make_shared<Edge>();
+        store(edge->attributes, attributes);
+        ops.push_back({OpKind::EDGE, TokenType::EDGE, static_cast<uint32_t>(edges.size()),
+                       source, target, NodeTable::hash(source), NodeTable::hash(target)});
+        edges.push_back(std::move(edge));
+    }
+
+    void add_attributes(TokenType kind, const AttributeViews& attributes) override {
+        attribute_lists.emplace_back();
+        store(attribute_lists.back(), attributes);
+        ops.push_back({OpKind::ATTRIBUTES, kind, static_cast<uint32_t>(attribute_lists.size() - 1),
+                       {}, {}, 0, 0});
+    }
+
+private:
+    void store(AttributeList& target, const AttributeViews& attributes) {
+        for (const auto& attr : attributes) {
+            Symbol name = symbols->intern(attr.name);
+            target.set(name, symbols->store_value(name, attr.value));
+        }
+    }
+};
+
+struct Chunk {
+    // Slice of the input scanned for statement boundaries
+    size_t begin;
+    size_t end;
+    StatementSplitter splitter;
+    std::vector<StatementSplitter::Range> ranges;
+
+    // Parsed statements. The parser stays alive until the merge because
+    // ops refer to strings unescaped by its lexer.
+    std::unique_ptr<DotParser> parser;
+    ChunkBuilder builder;
+    bool failed = false;
+};
+
+// Runs task(0) .. task(count - 1), task(0) on the calling thread. An
+// exception thrown by any task is rethrown here once all of them finished.
+template <typename Task>
+void run_workers(size_t count, const Task& task) {
+    std::vector<std::exception_ptr> errors(count);
+    auto guarded = [&](size_t i) {
+        try {
+            task(i);
+        } catch (...) {
+            errors[i] = std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(count - 1);
+    for (size_t i = 1; i < count; i++) {
+        threads.emplace_back(guarded, i);
+    }
+    guarded(0);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (const auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+// Cuts the input after a newline near every multiple of size / count
+std::vector<Chunk> make_chunks(const char* data, size_t size, size_t count) {
+    std::vector<Chunk> chunks(1);
+    chunks[0].begin = 0;
+
+    for (size_t i = 1; i < count; i++) {
+        size_t target = std::max(size / count * i, chunks.back().begin + 1);
+        if (target >= size) break;
+        const void* newline = std::memchr(data + target, '\n', size - target);
+        if (!newline) break;
+        size_t cut = static_cast<size_t>(static_cast<const char*>(newline) - data) + 1;
+        if (cut >= size) break;
+
+        chunks.back().end = cut;
+        chunks.emplace_back();
+        chunks.back().begin = cut;
+        chunks.back().splitter = StatementSplitter::in_body(cut);
+    }
+    chunks.back().end = size;
+    return chunks;
+}
+
+// Moves attributes parsed into a chunk table over to the graph table.
+// Names are interned on first use, so the graph sees them in statement
+// order just as in a sequential parse. Values the graph table deduplicates
+// are stored there again; the rest stay in the chunk table, which the graph
+// adopts afterwards.
+class SymbolMap {
+public:
+    SymbolMap(const SymbolTable& local, SymbolTable& graph)
+        : local_(local), graph_(graph), map_(local.size(), NO_SYMBOL) {}
+
+    void apply(AttributeList& attributes) {
+        attributes.remap([this](Attribute& attr) {
+            if (attr.name >= symbols::WELL_KNOWN_COUNT) {
+                Symbol& mapped = map_[attr.name];
+                if (mapped == NO_SYMBOL) {
+                    mapped = graph_.intern(local_.name(attr.name));
+                }
+                attr.name = mapped;
+            }
+            if (symbols::interns_values(attr.name)) {
+                attr.value = graph_.store_value(attr.name, attr.value);
+            }
+        });
+    }
+
+private:
+    const SymbolTable& local_;
+    SymbolTable& graph_;
+    std::vector<Symbol> map_;
+};
+
+void replay(const ChunkBuilder& chunk, AstBuilder& builder, const std::shared_ptr<Graph>& graph) {
+    SymbolMap map(*chunk.symbols, graph->symbols);
+
+    for (const auto& op : chunk.ops) {
+        switch (op.kind) {
+            case ChunkBuilder::OpKind::NODE: {
+                const auto& node = chunk.nodes[op.index];
+                map.apply(node->attributes);
+                builder.merge_node(node, op.id_hash);
+                break;
+            }
+            case ChunkBuilder::OpKind::EDGE: {
+                const auto& edge = chunk.edges[op.index];
+                map.apply(edge->attributes);
+                builder.merge_edge(edge, op.id, op.id_hash, op.target, op.target_hash);
+                break;
+            }
+            case ChunkBuilder::OpKind::ATTRIBUTES: {
+                AttributeList attributes = chunk.attribute_lists[op.index];
+                map.apply(attributes);
+                builder.merge_attributes(op.attribute_kind, attributes);
+                break;
+            }
+            case ChunkBuilder::OpKind::BEGIN_SUBGRAPH:
+                builder.begin_subgraph(op.id);
+                break;
+            case ChunkBuilder::OpKind::END_SUBGRAPH:
+                builder.end_subgraph();
+                break;
+        }
+    }
+}
+
+} // namespace
+
+std::shared_ptr<Graph> parse_parallel(const std::string& text, size_t workers) {
+    return parse_parallel(text.data(), text.length(), workers);
+}
+
+std::shared_ptr<Graph> parse_parallel(const char* data, size_t size, size_t workers) {
+    if (workers == 0) {
+        workers = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+    workers = std::min(workers, size / MIN_SLICE_SIZE);
+    if (workers <= 1) {
+        return DotParser(data, size).parse();
+    }
+
+    std::vector<Chunk> chunks = make_chunks(data, size, workers);
+
+    // Every slice but the first is scanned assuming it starts between two
+    // statements of the graph body
+    run_workers(chunks.size(), [&](size_t i) {
+        Chunk& chunk = chunks[i];
+        chunk.splitter.feed(data + chunk.begin, chunk.end - chunk.begin, chunk.ranges);
+    });
+
+    // Rescan slices whose assumption did not hold, e.g. cuts inside a
+    // multi-line string, from the state the previous slice ended in
+    for (size_t i = 1; i < chunks.size(); i++) {
+        const StatementSplitter& previous = chunks[i - 1].splitter;
+        if (!previous.between_statements()) {
+            Chunk& chunk = chunks[i];
+            chunk.splitter = previous;
+            chunk.ranges.clear();
+            chunk.splitter.feed(data + chunk.begin, chunk.end - chunk.begin, chunk.ranges);
+        }
+    }
+
+    // Anything but a well-formed header, body and closing brace is left to
+    // the sequential parser, which reports errors with their exact position
+    const auto& first = chunks.front().ranges;
+    if (first.empty() || first.front().kind != StatementSplitter::RangeKind::HEADER ||
+        !chunks.back().splitter.finished()) {
+        return DotParser(data, size).parse();
+    }
+
+    run_workers(chunks.size(), [&](size_t i) {
+        Chunk& chunk = chunks[i];
+        size_t span_begin = size;
+        size_t span_end = 0;
+        for (const auto& range : chunk.ranges) {
+            if (range.kind == StatementSplitter::RangeKind::STATEMENT) {
+                span_begin = std::min(span_begin, range.begin);
+                span_end = std::max(span_end, range.end);
+            }
+        }
+        if (span_begin >= span_end) {
+            return;
+        }
+
+        try {
+            chunk.parser = std::make_unique<DotParser>(data + span_begin, span_end - span_begin);
+            chunk.parser->parse_statements(chunk.builder);
+        } catch (const ParseError&) {
+            chunk.failed = true;
+        }
+    });
+
+    for (const auto& chunk : chunks) {
+        if (chunk.failed) {
+            return DotParser(data, size).parse();
+        }
+    }
+
+    AstBuilder builder;
+    const auto& header = first.front();
+    DotParser(data + header.begin, header.end - header.begin).parse_header(builder);
+
+    std::shared_ptr<Graph> graph = builder.graph();
+    for (auto& chunk : chunks) {
+        replay(chunk.builder, builder, graph);
+        graph->symbols.adopt(std::move(chunk.builder.symbols));
+    }
+    builder.end_graph();
+    return graph;
+}
+
+} // namespace dot
+} // namespace xdot_cpp
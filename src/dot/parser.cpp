@@ -4,12 +4,232 @@
 namespace xdot_cpp {
 namespace dot {
 
-DotParser::DotParser(const std::string& text) : lexer_(text) {
+// AttributeList implementation
+void AttributeList::set(Symbol name, std::string_view value) {
+    if (name < symbols::WELL_KNOWN_COUNT) {
+        uint8_t slot = slots_[name];
+        if (slot != NO_SLOT) {
+            items_[slot].value = value;
+            return;
+        }
+        if (items_.size() < NO_SLOT) {
+            slots_[name] = static_cast<uint8_t>(items_.size());
+        }
+    } else {
+        for (auto& attr : items_) {
+            if (attr.name == name) {
+                attr.value = value;
+                return;
+            }
+        }
+    }
+    items_.emplace_back(name, value);
+}
+
+void AttributeList::clear() {
+    items_.clear();
+    slots_.fill(NO_SLOT);
+}
+
+const Attribute* AttributeList::find(Symbol name) const {
+    if (name < symbols::WELL_KNOWN_COUNT) {
+        uint8_t slot = slots_[name];
+        if (slot != NO_SLOT) {
+            return &items_[slot];
+        }
+        // Only lists too long for the slot table can hold unslotted entries
+        if (items_.size() <= NO_SLOT) {
+            return nullptr;
+        }
+    }
+    for (const auto& attr : items_) {
+        if (attr.name == name) {
+            return &attr;
+        }
+    }
+    return nullptr;
+}
+
+std::string_view AttributeList::get(Symbol name, std::string_view default_value) const {
+    const Attribute* attr = find(name);
+    return attr ? attr->value : default_value;
+}
+
+// AstBuilder implementation
+AstBuilder::AstBuilder(std::shared_ptr<Graph> graph) : graph_(std::move(graph)) {}
+
+void AstBuilder::begin_graph(Graph::Type type, bool strict, std::string_view id) {
+    graph_->type = type;
+    graph_->strict = strict;
+    graph_->id.assign(id);
+    scopes_.assign(1, Scope());
+}
+
+void AstBuilder::end_graph() {
+    graph_->node_defaults = scopes_.back().node_defaults;
+    graph_->edge_defaults = scopes_.back().edge_defaults;
+    scopes_.clear();
+}
+
+void AstBuilder::begin_subgraph(std::string_view id) {
+    subgraph_stack_.push_back(std::make_shared<Subgraph>(std::string(id)));
+    
+    Scope scope;
+    scope.node_defaults = scopes_.back().node_defaults;
+    scope.edge_defaults = scopes_.back().edge_defaults;
+    scopes_.push_back(std::move(scope));
+}
+
+void AstBuilder::end_subgraph() {
+    auto subgraph = subgraph_stack_.back();
+    subgraph_stack_.pop_back();
+    subgraph->node_defaults = scopes_.back().node_defaults;
+    subgraph->edge_defaults = scopes_.back().edge_defaults;
+    scopes_.pop_back();
+    
+    if (subgraph_stack_.empty()) {
+        graph_->subgraphs.push_back(subgraph);
+    } else {
+        subgraph_stack_.back()->subgraphs.push_back(subgraph);
+    }
+}
+
+void AstBuilder::add_node(std::string_view id, const AttributeViews& attributes) {
+    NodeIndex index = resolve_node(id, NodeTable::hash(id));
+    store_attributes(graph_->nodes[index]->attributes, attributes);
+}
+
+void AstBuilder::add_edge(std::string_view source, std::string_view target,
+                          const AttributeViews& attributes) {
+    // Source first: resolving may create the node
+    NodeIndex source_index = resolve_node(source, NodeTable::hash(source));
+    NodeIndex target_index = resolve_node(target, NodeTable::hash(target));
+    auto edge = std::make_shared<Edge>(source_index, target_index);
+    store_attributes(edge->attributes, attributes);
+    append_edge(std::move(edge));
+}
+
+void AstBuilder::add_attributes(TokenType kind, const AttributeViews& attributes) {
+    Scope& scope = scopes_.back();
+    
+    if (kind == TokenType::NODE) {
+        scope.node_defaults = merge_defaults(scope.node_defaults, attributes);
+    } else if (kind == TokenType::EDGE) {
+        scope.edge_defaults = merge_defaults(scope.edge_defaults, attributes);
+    } else {
+        store_attributes(attribute_target(), attributes);
+    }
+}
+
+void AstBuilder::merge_node(std::shared_ptr<Node> node, uint32_t id_hash) {
+    std::string_view id = node->id;
+    resolve_node(id, id_hash, std::move(node));
+}
+
+void AstBuilder::merge_edge(std::shared_ptr<Edge> edge,
+                            std::string_view source, uint32_t source_hash,
+                            std::string_view target, uint32_t target_hash) {
+    edge->source = resolve_node(source, source_hash);
+    edge->target = resolve_node(target, target_hash);
+    append_edge(std::move(edge));
+}
+
+void AstBuilder::merge_attributes(TokenType kind, const AttributeList& attributes) {
+    Scope& scope = scopes_.back();
+    
+    if (kind == TokenType::NODE) {
+        scope.node_defaults = merge_defaults(scope.node_defaults, attributes);
+    } else if (kind == TokenType::EDGE) {
+        scope.edge_defaults = merge_defaults(scope.edge_defaults, attributes);
+    } else {
+        AttributeList& target = attribute_target();
+        for (const auto& attr : attributes) {
+            target.set(attr.name, attr.value);
+        }
+    }
+}
+
+NodeIndex AstBuilder::resolve_node(std::string_view id, uint32_t id_hash, std::shared_ptr<Node> node) {
+    NodeIndex index = graph_->node_table.find(id, id_hash);
+    
+    if (index == NO_NODE) {
+        // First mention, either a node statement or an edge endpoint
+        if (!node) {
+            node = std::make_shared<Node>(std::string(id));
+        }
+        node->defaults = scopes_.back().node_defaults;
+        graph_->nodes.push_back(std::move(node));
+        index = graph_->node_table.insert(graph_->nodes.back()->id, id_hash);
+    } else if (node) {
+        AttributeList& existing = graph_->nodes[index]->attributes;
+        for (const auto& attr : node->attributes) {
+            existing.set(attr.name, attr.value);
+        }
+    }
+    
+    if (!subgraph_stack_.empty() && scopes_.back().members.insert(index).second) {
+        subgraph_stack_.back()->nodes.push_back(index);
+    }
+    return index;
+}
+
+void AstBuilder::append_edge(std::shared_ptr<Edge> edge) {
+    edge->defaults = scopes_.back().edge_defaults;
+    
+    if (!subgraph_stack_.empty()) {
+        subgraph_stack_.back()->edges.push_back(static_cast<EdgeIndex>(graph_->edges.size()));
+    }
+    graph_->edges.push_back(std::move(edge));
+}
+
+AttributeList& AstBuilder::attribute_target() {
+    return subgraph_stack_.empty() ? graph_->attributes : subgraph_stack_.back()->attributes;
+}
+
+void AstBuilder::store_attributes(AttributeList& target, const AttributeViews& attributes) {
+    SymbolTable& symbols = graph_->symbols;
+    for (const auto& attr : attributes) {
+        Symbol name = symbols.intern(attr.name);
+        target.set(name, symbols.store_value(name, attr.value));
+    }
+}
+
+AttributeSet AstBuilder::merge_defaults(const AttributeSet& defaults, const AttributeViews& attributes) {
+    // Elements declared so far keep referring to the old set
+    auto merged = defaults ? std::make_shared<AttributeList>(*defaults) : std::make_shared<AttributeList>();
+    store_attributes(*merged, attributes);
+    return merged;
+}
+
+AttributeSet AstBuilder::merge_defaults(const AttributeSet& defaults, const AttributeList& attributes) {
+    auto merged = defaults ? std::make_shared<AttributeList>(*defaults) : std::make_shared<AttributeList>();
+    for (const auto& attr : attributes) {
+        merged->set(attr.name, attr.value);
+    }
+    return merged;
+}
+
+// DotParser implementation
+DotParser::DotParser(const std::string& text) : lexer_(text), depth_(0) {
+    advance(); // Initialize current_token_
+}
+
+DotParser::DotParser(const char* data, size_t size) : lexer_(data, size), depth_(0) {
     advance(); // Initialize current_token_
 }
 
 std::shared_ptr<Graph> DotParser::parse() {
-    return parse_graph();
+    AstBuilder builder;
+    parse(builder);
+    return builder.graph();
+}
+
+void DotParser::parse(GraphBuilder& builder) {
+    parse_header(builder);
+    parse_statements(builder);
+    
+    consume(TokenType::RCURLY);
+    builder.end_graph();
 }
 
 void DotParser::consume(TokenType expected_type) {
@@ -17,7 +237,7 @@ void DotParser::consume(TokenType expected_type) {
         std::ostringstream oss;
         oss << "Expected token type " << static_cast<int>(expected_type) 
             << " but got " << static_cast<int>(current_token_.type);
-        throw ParseError(oss.str(), current_token_.line, current_token_.column);
+        throw ParseError(oss.str(), lexer_.location(current_token_.offset));
     }
     advance();
 }
@@ -26,191 +246,133 @@ void DotParser::advance() {
     current_token_ = lexer_.next_token();
 }
 
-std::shared_ptr<Graph> DotParser::parse_graph() {
-    auto graph = std::make_shared<Graph>();
+void DotParser::parse_header(GraphBuilder& builder) {
+    bool strict = false;
+    Graph::Type type;
+    std::string_view id;
     
     // Parse optional 'strict' keyword
     if (current_token_.type == TokenType::STRICT) {
-        graph->strict = true;
+        strict = true;
         advance();
     }
     
     // Parse graph type
     if (current_token_.type == TokenType::GRAPH) {
-        graph->type = Graph::GRAPH;
+        type = Graph::GRAPH;
         advance();
     } else if (current_token_.type == TokenType::DIGRAPH) {
-        graph->type = Graph::DIGRAPH;
+        type = Graph::DIGRAPH;
         advance();
     } else {
-        throw ParseError("Expected 'graph' or 'digraph'", current_token_.line, current_token_.column);
+        throw ParseError("Expected 'graph' or 'digraph'", lexer_.location(current_token_.offset));
     }
     
     // Parse optional graph ID
     if (current_token_.type == TokenType::ID || current_token_.type == TokenType::STR_ID) {
-        graph->id = parse_id();
+        id = parse_id();
     }
     
     consume(TokenType::LCURLY);
-    
-    // Parse statements
+    builder.begin_graph(type, strict, id);
+}
+
+void DotParser::parse_statements(GraphBuilder& builder) {
     while (current_token_.type != TokenType::RCURLY && current_token_.type != TokenType::EOF_TOKEN) {
-        if (current_token_.type == TokenType::NODE) {
-            // Node attribute statement
-            advance();
-            graph->attributes = parse_attributes();
-        } else if (current_token_.type == TokenType::EDGE) {
-            // Edge attribute statement
-            advance();
-            graph->attributes = parse_attributes();
-        } else if (current_token_.type == TokenType::GRAPH) {
-            // Graph attribute statement
-            advance();
-            auto attrs = parse_attributes();
-            graph->attributes.insert(graph->attributes.end(), attrs.begin(), attrs.end());
-        } else if (current_token_.type == TokenType::SUBGRAPH) {
-            // Subgraph
-            auto subgraph = parse_subgraph();
-            graph->subgraphs.push_back(subgraph);
-        } else if (current_token_.type == TokenType::ID || current_token_.type == TokenType::STR_ID) {
-            // Node, edge, or attribute assignment statement
-            std::string id = parse_id();
-            
-            if (current_token_.type == TokenType::EDGE_OP) {
-                // Edge statement
-                auto edge = parse_edge(id);
-                graph->edges.push_back(edge);
-            } else if (current_token_.type == TokenType::EQUAL) {
-                // Graph attribute assignment: ID = ID
-                advance(); // consume '='
-                std::string value = parse_id();
-                graph->attributes.push_back({id, value});
-            } else {
-                // Node statement
-                auto node = std::make_shared<Node>(id);
-                if (current_token_.type == TokenType::LSQUARE) {
-                    node->attributes = parse_attributes();
-                }
-                graph->nodes.push_back(node);
-            }
-        } else {
-            std::string token_str = current_token_.text.empty() ? 
-                std::to_string(static_cast<int>(current_token_.type)) : current_token_.text;
-            throw ParseError("Unexpected token in graph body: '" + token_str + "' at line " + 
-                           std::to_string(current_token_.line), current_token_.line, current_token_.column);
-        }
+        parse_statement(builder);
         
         // Optional semicolon
         if (current_token_.type == TokenType::SEMI) {
             advance();
         }
     }
-    
-    consume(TokenType::RCURLY);
-    return graph;
 }
 
-std::shared_ptr<Subgraph> DotParser::parse_subgraph() {
-    consume(TokenType::SUBGRAPH);
-    
-    auto subgraph = std::make_shared<Subgraph>();
-    
-    // Parse optional subgraph ID
-    if (current_token_.type == TokenType::ID || current_token_.type == TokenType::STR_ID) {
-        subgraph->id = parse_id();
-    }
-    
-    consume(TokenType::LCURLY);
-    
-    // Parse subgraph body (similar to graph body)
-    while (current_token_.type != TokenType::RCURLY && current_token_.type != TokenType::EOF_TOKEN) {
-        if (current_token_.type == TokenType::NODE) {
-            // Node attribute statement
-            advance();
-            auto attrs = parse_attributes();
-            subgraph->attributes.insert(subgraph->attributes.end(), attrs.begin(), attrs.end());
-        } else if (current_token_.type == TokenType::EDGE) {
-            // Edge attribute statement
-            advance();
-            auto attrs = parse_attributes();
-            subgraph->attributes.insert(subgraph->attributes.end(), attrs.begin(), attrs.end());
-        } else if (current_token_.type == TokenType::GRAPH) {
-            // Graph attribute statement
+void DotParser::parse_statement(GraphBuilder& builder) {
+    if (current_token_.type == TokenType::NODE ||
+        current_token_.type == TokenType::EDGE ||
+        current_token_.type == TokenType::GRAPH) {
+        // Node, edge or graph attribute statement
+        TokenType kind = current_token_.type;
+        advance();
+        parse_attributes();
+        builder.add_attributes(kind, attributes_);
+    } else if (current_token_.type == TokenType::SUBGRAPH) {
+        parse_subgraph(builder);
+    } else if (current_token_.type == TokenType::ID || current_token_.type == TokenType::STR_ID) {
+        // Node, edge, or attribute assignment statement
+        std::string_view id = parse_id();
+        
+        if (current_token_.type == TokenType::EDGE_OP) {
+            // Edge statement
             advance();
-            auto attrs = parse_attributes();
-            subgraph->attributes.insert(subgraph->attributes.end(), attrs.begin(), attrs.end());
-        } else if (current_token_.type == TokenType::SUBGRAPH) {
-            auto nested_subgraph = parse_subgraph();
-            subgraph->subgraphs.push_back(nested_subgraph);
-        } else if (current_token_.type == TokenType::ID || current_token_.type == TokenType::STR_ID) {
-            std::string id = parse_id();
-            
-            if (current_token_.type == TokenType::EDGE_OP) {
-                auto edge = parse_edge(id);
-                subgraph->edges.push_back(edge);
-            } else if (current_token_.type == TokenType::EQUAL) {
-                // Subgraph attribute assignment: ID = ID
-                advance(); // consume '='
-                std::string value = parse_id();
-                subgraph->attributes.push_back({id, value});
-            } else {
-                auto node = std::make_shared<Node>(id);
-                if (current_token_.type == TokenType::LSQUARE) {
-                    node->attributes = parse_attributes();
-                }
-                subgraph->nodes.push_back(node);
+            std::string_view target_id = parse_id();
+            attributes_.clear();
+            if (current_token_.type == TokenType::LSQUARE) {
+                parse_attributes();
             }
+            builder.add_edge(id, target_id, attributes_);
+        } else if (current_token_.type == TokenType::EQUAL) {
+            // Graph attribute assignment: ID = ID
+            advance(); // consume '='
+            std::string_view value = parse_id();
+            attributes_.clear();
+            attributes_.push_back({id, value});
+            builder.add_attributes(TokenType::GRAPH, attributes_);
         } else {
-            throw ParseError("Unexpected token in subgraph body", current_token_.line, current_token_.column);
-        }
-        
-        if (current_token_.type == TokenType::SEMI) {
-            advance();
+            // Node statement
+            attributes_.clear();
+            if (current_token_.type == TokenType::LSQUARE) {
+                parse_attributes();
+            }
+            builder.add_node(id, attributes_);
         }
+    } else if (depth_ > 0) {
+        throw ParseError("Unexpected token in subgraph body", lexer_.location(current_token_.offset));
+    } else {
+        std::string token_str = current_token_.text.empty() ? 
+            std::to_string(static_cast<int>(current_token_.type)) : std::string(current_token_.text);
+        SourceLocation location = lexer_.location(current_token_.offset);
+        throw ParseError("Unexpected token in graph body: '" + token_str + "' at line " + 
+                       std::to_string(location.line), location);
     }
-    
-    consume(TokenType::RCURLY);
-    return subgraph;
 }
 
-std::shared_ptr<Node> DotParser::parse_node() {
-    std::string id = parse_id();
-    auto node = std::make_shared<Node>(id);
+void DotParser::parse_subgraph(GraphBuilder& builder) {
+    consume(TokenType::SUBGRAPH);
     
-    if (current_token_.type == TokenType::LSQUARE) {
-        node->attributes = parse_attributes();
+    // Parse optional subgraph ID
+    std::string_view id;
+    if (current_token_.type == TokenType::ID || current_token_.type == TokenType::STR_ID) {
+        id = parse_id();
     }
     
-    return node;
-}
-
-std::shared_ptr<Edge> DotParser::parse_edge(const std::string& source_id) {
-    consume(TokenType::EDGE_OP);
-    
-    std::string target_id = parse_id();
-    auto edge = std::make_shared<Edge>(source_id, target_id);
+    consume(TokenType::LCURLY);
+    builder.begin_subgraph(id);
     
-    if (current_token_.type == TokenType::LSQUARE) {
-        edge->attributes = parse_attributes();
-    }
+    // Subgraph bodies hold the same statements as the graph body
+    depth_++;
+    parse_statements(builder);
+    depth_--;
     
-    return edge;
+    consume(TokenType::RCURLY);
+    builder.end_subgraph();
 }
 
-AttributeList DotParser::parse_attributes() {
-    AttributeList attributes;
+void DotParser::parse_attributes() {
+    attributes_.clear();
     
     consume(TokenType::LSQUARE);
     
     while (current_token_.type != TokenType::RSQUARE && current_token_.type != TokenType::EOF_TOKEN) {
-        std::string name = parse_id();
+        std::string_view name = parse_id();
         
         if (current_token_.type == TokenType::EQUAL) {
             advance();
-            std::string value = parse_id();
-            attributes.emplace_back(name, value);
+            std::string_view value = parse_id();
+            attributes_.push_back({name, value});
         } else {
-            attributes.emplace_back(name, "");
+            attributes_.push_back({name, std::string_view()});
         }
         
         if (current_token_.type == TokenType::COMMA || current_token_.type == TokenType::SEMI) {
@@ -219,11 +381,10 @@ AttributeList DotParser::parse_attributes() {
     }
     
     consume(TokenType::RSQUARE);
-    return attributes;
 }
 
-std::string DotParser::parse_id() {
-    std::string id;
+std::string_view DotParser::parse_id() {
+    std::string_view id;
     
     if (current_token_.type == TokenType::ID || 
         current_token_.type == TokenType::STR_ID || 
@@ -231,7 +392,7 @@ std::string DotParser::parse_id() {
         id = current_token_.text;
         advance();
     } else {
-        throw ParseError("Expected identifier", current_token_.line, current_token_.column);
+        throw ParseError("Expected identifier", lexer_.location(current_token_.offset));
     }
     
     return id;
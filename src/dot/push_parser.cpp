@@ -0,0 +1,124 @@
+#include "xdot_cpp/dot/push_parser.h"
+#include <cstring>
+
+namespace xdot_cpp {
+namespace dot {
+
+DotPushParser::DotPushParser(StatementCallback on_statement)
+    : on_statement_(std::move(on_statement)), builder_(ast_builder_),
+      buffer_offset_(0), buffer_location_(1, 1) {}
+
+DotPushParser::DotPushParser(GraphBuilder& builder)
+    : builder_(builder), buffer_offset_(0), buffer_location_(1, 1) {}
+
+void DotPushParser::feed(const char* data, size_t size) {
+    if (splitter_.finished()) {
+        return;
+    }
+
+    buffer_.append(data, size);
+    ranges_.clear();
+    splitter_.feed(data, size, ranges_);
+
+    for (const auto& range : ranges_) {
+        parse_range(range);
+    }
+
+    discard_until(splitter_.pending_begin());
+}
+
+std::shared_ptr<Graph> DotPushParser::finish() {
+    if (!splitter_.finished()) {
+        throw ParseError("Unexpected end of input", buffer_location_);
+    }
+    return ast_builder_.graph();
+}
+
+void DotPushParser::parse_range(const StatementSplitter::Range& range) {
+    if (range.kind == StatementSplitter::RangeKind::END) {
+        builder_.end_graph();
+        return;
+    }
+
+    const Graph& graph = *ast_builder_.graph();
+    size_t buffer_pos = range.begin - buffer_offset_;
+    StatementRange added = {
+        graph.nodes.size(), 0,
+        graph.edges.size(), 0,
+        graph.subgraphs.size(), 0
+    };
+
+    try {
+        DotParser parser(buffer_.data() + buffer_pos, range.end - range.begin);
+        if (range.kind == StatementSplitter::RangeKind::HEADER) {
+            parser.parse_header(builder_);
+        } else {
+            parser.parse_statements(builder_);
+        }
+    } catch (const ParseError& e) {
+        SourceLocation location = absolute_location(buffer_pos, e);
+        // Messages that quote their line number get the absolute one too
+        std::string message = e.what();
+        std::string quoted = " at line " + std::to_string(e.line());
+        if (message.size() >= quoted.size() &&
+            message.compare(message.size() - quoted.size(), quoted.size(), quoted) == 0) {
+            message.replace(message.size() - quoted.size(), quoted.size(),
+                            " at line " + std::to_string(location.line));
+        }
+        throw ParseError(message, location);
+    }
+
+    if (range.kind == StatementSplitter::RangeKind::STATEMENT && on_statement_) {
+        added.node_count = graph.nodes.size() - added.first_node;
+        added.edge_count = graph.edges.size() - added.first_edge;
+        added.subgraph_count = graph.subgraphs.size() - added.first_subgraph;
+        on_statement_(graph, added);
+    }
+}
+
+void DotPushParser::discard_until(size_t offset) {
+    size_t count = offset - buffer_offset_;
+    if (count == 0) {
+        return;
+    }
+
+    // Keep the position of the new buffer start up to date
+    const char* begin = buffer_.data();
+    const char* end = begin + count;
+    const char* line_start = nullptr;
+    for (const char* p = begin; p < end; p++) {
+        p = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        if (!p) break;
+        buffer_location_.line++;
+        line_start = p + 1;
+    }
+    if (line_start) {
+        buffer_location_.column = static_cast<size_t>(end - line_start) + 1;
+    } else {
+        buffer_location_.column += count;
+    }
+
+    buffer_.erase(0, count);
+    buffer_offset_ = offset;
+}
+
+SourceLocation DotPushParser::absolute_location(size_t buffer_pos, const ParseError& error) const {
+    // Position of the statement start relative to the buffer start
+    SourceLocation base = buffer_location_;
+    for (size_t i = 0; i < buffer_pos; i++) {
+        if (buffer_[i] == '\n') {
+            base.line++;
+            base.column = 1;
+        } else {
+            base.column++;
+        }
+    }
+
+    if (error.line() <= 1) {
+        return SourceLocation(base.line, base.column + error.column() - 1);
+    }
+    return SourceLocation(base.line + error.line() - 1, error.column());
+}
+
+} // namespace dot
+} // namespace xdot_cpp
@@ -0,0 +1,263 @@
+#include "xdot_cpp/dot/scanner.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define XDOT_CPP_HAVE_SSE2 1
+#endif
+#if defined(__GNUC__) || defined(__clang__)
+#define XDOT_CPP_HAVE_AVX2 1
+#endif
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace xdot_cpp {
+namespace dot {
+
+namespace {
+
+struct Keyword {
+    std::string_view text;
+    TokenType type;
+};
+
+// Indexed by keyword_hash(); collision-free for the six DOT keywords
+constexpr Keyword keyword_table[8] = {
+    {"edge", TokenType::EDGE},
+    {"", TokenType::ID},
+    {"node", TokenType::NODE},
+    {"graph", TokenType::GRAPH},
+    {"strict", TokenType::STRICT},
+    {"", TokenType::ID},
+    {"subgraph", TokenType::SUBGRAPH},
+    {"digraph", TokenType::DIGRAPH}
+};
+
+inline unsigned keyword_hash(std::string_view text) {
+    unsigned first = static_cast<unsigned char>(text.front()) | 0x20;
+    unsigned last = static_cast<unsigned char>(text.back()) | 0x20;
+    return ((first << 1) + (last << 1) + static_cast<unsigned>(text.length())) & 7;
+}
+
+inline unsigned count_trailing_zeros(unsigned mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+// Scalar kernels (also used for the tails of the vector kernels)
+
+size_t skip_whitespace_scalar(const char* data, size_t pos, size_t end) {
+    while (pos < end && char_classes.is(data[pos], CC_SPACE)) {
+        pos++;
+    }
+    return pos;
+}
+
+size_t skip_identifier_scalar(const char* data, size_t pos, size_t end) {
+    while (pos < end && char_classes.is(data[pos], CC_ID_CHAR)) {
+        pos++;
+    }
+    return pos;
+}
+
+size_t skip_string_body_scalar(const char* data, size_t pos, size_t end) {
+    while (pos < end && data[pos] != '"' && data[pos] != '\\') {
+        pos++;
+    }
+    return pos;
+}
+
+#ifdef XDOT_CPP_HAVE_SSE2
+
+// Unsigned byte range test: lo <= v <= hi
+inline __m128i in_range_sse2(__m128i v, char lo, char hi) {
+    __m128i ge_lo = _mm_cmpeq_epi8(_mm_max_epu8(v, _mm_set1_epi8(lo)), v);
+    __m128i le_hi = _mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8(hi)), v);
+    return _mm_and_si128(ge_lo, le_hi);
+}
+
+size_t skip_whitespace_sse2(const char* data, size_t pos, size_t end) {
+    const __m128i space = _mm_set1_epi8(' ');
+    while (pos + 16 <= end) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        __m128i ws = _mm_or_si128(_mm_cmpeq_epi8(v, space), in_range_sse2(v, '\t', '\r'));
+        unsigned stop = ~static_cast<unsigned>(_mm_movemask_epi8(ws)) & 0xFFFFu;
+        if (stop) {
+            return pos + count_trailing_zeros(stop);
+        }
+        pos += 16;
+    }
+    return skip_whitespace_scalar(data, pos, end);
+}
+
+size_t skip_identifier_sse2(const char* data, size_t pos, size_t end) {
+    const __m128i underscore = _mm_set1_epi8('_');
+    while (pos + 16 <= end) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        __m128i id = _mm_or_si128(in_range_sse2(v, '0', '9'), in_range_sse2(v, 'A', 'Z'));
+        id = _mm_or_si128(id, in_range_sse2(v, 'a', 'z'));
+        id = _mm_or_si128(id, _mm_cmpeq_epi8(v, underscore));
+        // Bytes >= 0x80 have their sign bit set
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(id) | _mm_movemask_epi8(v));
+        unsigned stop = ~mask & 0xFFFFu;
+        if (stop) {
+            return pos + count_trailing_zeros(stop);
+        }
+        pos += 16;
+    }
+    return skip_identifier_scalar(data, pos, end);
+}
+
+size_t skip_string_body_sse2(const char* data, size_t pos, size_t end) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    while (pos + 16 <= end) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        __m128i special = _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash));
+        unsigned stop = static_cast<unsigned>(_mm_movemask_epi8(special));
+        if (stop) {
+            return pos + count_trailing_zeros(stop);
+        }
+        pos += 16;
+    }
+    return skip_string_body_scalar(data, pos, end);
+}
+
+#endif // XDOT_CPP_HAVE_SSE2
+
+#ifdef XDOT_CPP_HAVE_AVX2
+
+__attribute__((target("avx2")))
+inline __m256i in_range_avx2(__m256i v, char lo, char hi) {
+    __m256i ge_lo = _mm256_cmpeq_epi8(_mm256_max_epu8(v, _mm256_set1_epi8(lo)), v);
+    __m256i le_hi = _mm256_cmpeq_epi8(_mm256_min_epu8(v, _mm256_set1_epi8(hi)), v);
+    return _mm256_and_si256(ge_lo, le_hi);
+}
+
+__attribute__((target("avx2")))
+size_t skip_whitespace_avx2(const char* data, size_t pos, size_t end) {
+    const __m256i space = _mm256_set1_epi8(' ');
+    while (pos + 32 <= end) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+        __m256i ws = _mm256_or_si256(_mm256_cmpeq_epi8(v, space), in_range_avx2(v, '\t', '\r'));
+        unsigned stop = ~static_cast<unsigned>(_mm256_movemask_epi8(ws));
+        if (stop) {
+            return pos + count_trailing_zeros(stop);
+        }
+        pos += 32;
+    }
+    return skip_whitespace_scalar(data, pos, end);
+}
+
+__attribute__((target("avx2")))
+size_t skip_identifier_avx2(const char* data, size_t pos, size_t end) {
+    const __m256i underscore = _mm256_set1_epi8('_');
+    while (pos + 32 <= end) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+        __m256i id = _mm256_or_si256(in_range_avx2(v, '0', '9'), in_range_avx2(v, 'A', 'Z'));
+        id = _mm256_or_si256(id, in_range_avx2(v, 'a', 'z'));
+        id = _mm256_or_si256(id, _mm256_cmpeq_epi8(v, underscore));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(id) | _mm256_movemask_epi8(v));
+        unsigned stop = ~mask;
+        if (stop) {
+            return pos + count_trailing_zeros(stop);
+        }
+        pos += 32;
+    }
+    return skip_identifier_scalar(data, pos, end);
+}
+
+__attribute__((target("avx2")))
+size_t skip_string_body_avx2(const char* data, size_t pos, size_t end) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    while (pos + 32 <= end) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+        __m256i special = _mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, backslash));
+        unsigned stop = static_cast<unsigned>(_mm256_movemask_epi8(special));
+        if (stop) {
+            return pos + count_trailing_zeros(stop);
+        }
+        pos += 32;
+    }
+    return skip_string_body_scalar(data, pos, end);
+}
+
+#endif // XDOT_CPP_HAVE_AVX2
+
+using ScanFn = size_t (*)(const char*, size_t, size_t);
+
+struct ScanKernels {
+    ScanFn skip_whitespace;
+    ScanFn skip_identifier;
+    ScanFn skip_string_body;
+    const char* name;
+};
+
+ScanKernels select_kernels() {
+#ifdef XDOT_CPP_HAVE_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return {skip_whitespace_avx2, skip_identifier_avx2, skip_string_body_avx2, "avx2"};
+    }
+#endif
+#ifdef XDOT_CPP_HAVE_SSE2
+    return {skip_whitespace_sse2, skip_identifier_sse2, skip_string_body_sse2, "sse2"};
+#else
+    return {skip_whitespace_scalar, skip_identifier_scalar, skip_string_body_scalar, "scalar"};
+#endif
+}
+
+const ScanKernels kernels = select_kernels();
+
+} // namespace
+
+TokenType lookup_keyword(std::string_view text) {
+    if (text.length() < 4 || text.length() > 8) {
+        return TokenType::ID;
+    }
+
+    const Keyword& keyword = keyword_table[keyword_hash(text)];
+    if (keyword.text.length() != text.length()) {
+        return TokenType::ID;
+    }
+
+    // Keywords are case-independent in DOT
+    for (size_t i = 0; i < text.length(); i++) {
+        if ((static_cast<unsigned char>(text[i]) | 0x20) != static_cast<unsigned char>(keyword.text[i])) {
+            return TokenType::ID;
+        }
+    }
+    return keyword.type;
+}
+
+namespace scan {
+
+size_t skip_whitespace(const char* data, size_t pos, size_t end) {
+    return kernels.skip_whitespace(data, pos, end);
+}
+
+size_t skip_identifier(const char* data, size_t pos, size_t end) {
+    return kernels.skip_identifier(data, pos, end);
+}
+
+size_t skip_string_body(const char* data, size_t pos, size_t end) {
+    return kernels.skip_string_body(data, pos, end);
+}
+
+const char* kernel_name() {
+    return kernels.name;
+}
+
+} // namespace scan
+
+} // namespace dot
+} // namespace xdot_cpp
@@ -0,0 +1,259 @@
+#include "xdot_cpp/dot/statement_splitter.h"
+#include "xdot_cpp/dot/scanner.h"
+#include <cstring>
+#include <string_view>
+
+namespace xdot_cpp {
+namespace dot {
+
+StatementSplitter::StatementSplitter()
+    : state_(State::NORMAL), last_(Last::NONE), offset_(0), statement_begin_(0),
+      brace_depth_(0), bracket_depth_(0), html_depth_(0), dash_pos_(0),
+      keyword_(), keyword_length_(0), finished_(false) {}
+
+StatementSplitter StatementSplitter::in_body(size_t offset) {
+    StatementSplitter splitter;
+    splitter.offset_ = offset;
+    splitter.statement_begin_ = offset;
+    splitter.brace_depth_ = 1;
+    return splitter;
+}
+
+void StatementSplitter::feed(const char* data, size_t size, std::vector<Range>& out) {
+    size_t i = 0;
+
+    while (i < size && !finished_) {
+        char c = data[i];
+
+        switch (state_) {
+            case State::NORMAL:
+                if (char_classes.is(c, CC_SPACE)) {
+                    i = scan::skip_whitespace(data, i, size);
+                    continue;
+                }
+                scan_normal(c, offset_ + i, out);
+                break;
+
+            case State::IDENTIFIER: {
+                size_t run_end = scan::skip_identifier(data, i, size);
+                for (size_t k = i; k < run_end && keyword_length_ < sizeof(keyword_); k++) {
+                    keyword_[keyword_length_++] = static_cast<char>(data[k] | 0x20);
+                }
+                i = run_end;
+                if (i < size && data[i] == '.') {
+                    // Decimal point of a numeral
+                    keyword_length_ = sizeof(keyword_);
+                    i++;
+                } else if (i < size) {
+                    end_identifier();
+                    state_ = State::NORMAL;
+                }
+                continue; // data[i], if any, starts the next token
+            }
+
+            case State::STRING:
+                i = scan::skip_string_body(data, i, size);
+                if (i >= size) {
+                    continue;
+                }
+                if (data[i] == '"') {
+                    state_ = State::NORMAL;
+                    last_ = Last::OPERAND;
+                } else {
+                    // The escaped character may arrive in the next chunk
+                    state_ = State::STRING_ESCAPE;
+                }
+                break;
+
+            case State::STRING_ESCAPE:
+                state_ = State::STRING;
+                break;
+
+            case State::HTML:
+                if (c == '<') {
+                    html_depth_++;
+                } else if (c == '>' && --html_depth_ == 0) {
+                    state_ = State::NORMAL;
+                    last_ = Last::OPERAND;
+                }
+                break;
+
+            case State::SLASH:
+                if (c == '/') {
+                    state_ = State::LINE_COMMENT;
+                } else if (c == '*') {
+                    state_ = State::BLOCK_COMMENT;
+                } else {
+                    // Stray '/': leave it for the parser to report
+                    state_ = State::NORMAL;
+                    continue;
+                }
+                break;
+
+            case State::LINE_COMMENT: {
+                const void* newline = std::memchr(data + i, '\n', size - i);
+                if (!newline) {
+                    i = size;
+                    continue;
+                }
+                i = static_cast<size_t>(static_cast<const char*>(newline) - data);
+                state_ = State::NORMAL;
+                break;
+            }
+
+            case State::BLOCK_COMMENT:
+                if (c == '*') {
+                    state_ = State::BLOCK_COMMENT_STAR;
+                }
+                break;
+
+            case State::BLOCK_COMMENT_STAR:
+                if (c == '/') {
+                    state_ = State::NORMAL;
+                } else if (c != '*') {
+                    state_ = State::BLOCK_COMMENT;
+                }
+                break;
+
+            case State::DASH:
+                if (c == '>' || c == '-') {
+                    last_ = Last::OPERATOR;
+                    state_ = State::NORMAL;
+                    break;
+                }
+                state_ = State::NORMAL;
+                if (char_classes.is(c, CC_DIGIT) || c == '.') {
+                    // Negative numeral
+                    begin_operand(dash_pos_, out);
+                    state_ = State::IDENTIFIER;
+                    keyword_length_ = sizeof(keyword_);
+                }
+                continue;
+        }
+
+        i++;
+    }
+
+    offset_ += size;
+}
+
+void StatementSplitter::scan_normal(char c, size_t pos, std::vector<Range>& out) {
+    switch (c) {
+        case '"':
+            begin_operand(pos, out);
+            state_ = State::STRING;
+            return;
+        case '<':
+            begin_operand(pos, out);
+            state_ = State::HTML;
+            html_depth_ = 1;
+            return;
+        case '/':
+            state_ = State::SLASH;
+            return;
+        case '#':
+            state_ = State::LINE_COMMENT;
+            return;
+        case '-':
+            dash_pos_ = pos;
+            state_ = State::DASH;
+            return;
+        case '[':
+            bracket_depth_++;
+            last_ = Last::OPERATOR;
+            return;
+        case ']':
+            if (bracket_depth_ > 0) {
+                bracket_depth_--;
+            }
+            last_ = Last::OPERAND;
+            return;
+        case '{':
+            if (brace_depth_ == 0) {
+                brace_depth_ = 1;
+                close_range(RangeKind::HEADER, pos + 1, out);
+                last_ = Last::NONE;
+                return;
+            }
+            // An anonymous subgraph after a complete statement starts a new one
+            if (at_body_level() && last_ == Last::OPERAND) {
+                close_range(RangeKind::STATEMENT, pos, out);
+            }
+            brace_depth_++;
+            return;
+        case '}':
+            if (brace_depth_ == 0) {
+                return;
+            }
+            if (brace_depth_ == 1) {
+                if (last_ != Last::NONE) {
+                    close_range(RangeKind::STATEMENT, pos, out);
+                }
+                close_range(RangeKind::END, pos + 1, out);
+                brace_depth_ = 0;
+                finished_ = true;
+                return;
+            }
+            if (--brace_depth_ == 1) {
+                last_ = Last::OPERAND;
+            }
+            return;
+        case ';':
+            if (at_body_level()) {
+                close_range(RangeKind::STATEMENT, pos + 1, out);
+                last_ = Last::NONE;
+            }
+            return;
+        case '=':
+        case ':':
+        case ',':
+        case '+':
+            last_ = Last::OPERATOR;
+            return;
+        default:
+            if (char_classes.is(c, CC_ID_CHAR) || c == '.') {
+                begin_operand(pos, out);
+                state_ = State::IDENTIFIER;
+                keyword_[0] = static_cast<char>(c | 0x20);
+                keyword_length_ = 1;
+            }
+            // Anything else is left for the parser to report
+            return;
+    }
+}
+
+void StatementSplitter::begin_operand(size_t pos, std::vector<Range>& out) {
+    if (!at_body_level()) {
+        return;
+    }
+
+    // Two operands in a row means the previous statement has ended
+    if (last_ == Last::OPERAND) {
+        close_range(RangeKind::STATEMENT, pos, out);
+    }
+
+    if (last_ != Last::SUBGRAPH_HEAD) {
+        last_ = Last::OPERAND;
+    }
+}
+
+void StatementSplitter::end_identifier() {
+    if (!at_body_level() || keyword_length_ > 8) {
+        return;
+    }
+
+    std::string_view word(keyword_, keyword_length_);
+    if (word == "subgraph") {
+        last_ = Last::SUBGRAPH_HEAD;
+    } else if (word == "node" || word == "edge" || word == "graph") {
+        last_ = Last::OPERATOR;
+    }
+}
+
+void StatementSplitter::close_range(RangeKind kind, size_t end, std::vector<Range>& out) {
+    out.push_back({kind, statement_begin_, end});
+    statement_begin_ = end;
+}
+
+} // namespace dot
+} // namespace xdot_cpp
@@ -0,0 +1,116 @@
+#include "xdot_cpp/dot/symbol_table.h"
+#include <cstring>
+
+namespace xdot_cpp {
+namespace dot {
+
+namespace {
+
+constexpr std::string_view well_known_names[symbols::WELL_KNOWN_COUNT] = {
+    "label",
+    "pos",
+    "width",
+    "height",
+    "shape",
+    "style",
+    "color",
+    "fillcolor",
+    "fontname",
+    "fontsize",
+    "fontcolor",
+    "bb",
+    "lp",
+    "URL",
+    "_draw_",
+    "_ldraw_",
+    "_hdraw_",
+    "_tdraw_",
+    "_hldraw_",
+    "_tldraw_"
+};
+
+// Longer values are rarely repeated
+constexpr size_t MAX_INTERNED_VALUE = 24;
+
+constexpr size_t INITIAL_ARENA_SIZE = 16 * 1024;
+
+} // namespace
+
+namespace symbols {
+
+std::string_view well_known_name(Symbol symbol) {
+    return symbol < WELL_KNOWN_COUNT ? well_known_names[symbol] : std::string_view();
+}
+
+bool interns_values(Symbol symbol) {
+    switch (symbol) {
+        case POS:
+        case LP:
+        case BB:
+        case LABEL:
+        case URL:
+        case DRAW:
+        case LDRAW:
+        case HDRAW:
+        case TDRAW:
+        case HLDRAW:
+        case TLDRAW:
+            return false;
+        default:
+            return true;
+    }
+}
+
+} // namespace symbols
+
+SymbolTable::SymbolTable() : arena_(INITIAL_ARENA_SIZE), bytes_(0) {
+    names_.reserve(symbols::WELL_KNOWN_COUNT);
+    for (Symbol symbol = 0; symbol < symbols::WELL_KNOWN_COUNT; symbol++) {
+        names_.push_back(well_known_names[symbol]);
+        index_.emplace(well_known_names[symbol], symbol);
+    }
+}
+
+Symbol SymbolTable::intern(std::string_view text) {
+    auto it = index_.find(text);
+    if (it != index_.end()) {
+        return it->second;
+    }
+
+    Symbol symbol = static_cast<Symbol>(names_.size());
+    std::string_view stored = store(text);
+    names_.push_back(stored);
+    index_.emplace(stored, symbol);
+    return symbol;
+}
+
+Symbol SymbolTable::find(std::string_view text) const {
+    auto it = index_.find(text);
+    return it != index_.end() ? it->second : NO_SYMBOL;
+}
+
+std::string_view SymbolTable::store_value(Symbol name, std::string_view value) {
+    if (value.length() <= MAX_INTERNED_VALUE && symbols::interns_values(name)) {
+        return names_[intern(value)];
+    }
+    return store(value);
+}
+
+void SymbolTable::adopt(std::unique_ptr<SymbolTable> table) {
+    bytes_ += table->bytes_;
+    adopted_.push_back(std::move(table));
+}
+
+std::string_view SymbolTable::store(std::string_view text) {
+    if (text.empty()) {
+        return std::string_view();
+    }
+
+    char* copy = static_cast<char*>(arena_.allocate(text.length(), 1));
+    std::memcpy(copy, text.data(), text.length());
+    bytes_ += text.length();
+    return std::string_view(copy, text.length());
+}
+
+} // namespace dot
+} // namespace xdot_cpp
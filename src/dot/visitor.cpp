@@ -0,0 +1,76 @@
+#include "xdot_cpp/dot/visitor.h"
+#include "xdot_cpp/dot/push_parser.h"
+#include <vector>
+
+namespace xdot_cpp {
+namespace dot {
+
+namespace {
+
+constexpr size_t READ_CHUNK_SIZE = 64 * 1024;
+
+} // namespace
+
+// VisitorAdapter implementation
+void VisitorAdapter::begin_graph(Graph::Type type, bool strict, std::string_view id) {
+    visitor_.on_graph_begin(type, strict, id);
+}
+
+void VisitorAdapter::end_graph() {
+    visitor_.on_graph_end();
+}
+
+void VisitorAdapter::begin_subgraph(std::string_view id) {
+    visitor_.on_subgraph_begin(id);
+}
+
+void VisitorAdapter::end_subgraph() {
+    visitor_.on_subgraph_end();
+}
+
+void VisitorAdapter::add_node(std::string_view id, const AttributeViews& attributes) {
+    visitor_.on_node(id);
+    report_attributes(attributes);
+}
+
+void VisitorAdapter::add_edge(std::string_view source, std::string_view target,
+                              const AttributeViews& attributes) {
+    visitor_.on_edge(source, target);
+    report_attributes(attributes);
+}
+
+void VisitorAdapter::add_attributes(TokenType kind, const AttributeViews& attributes) {
+    visitor_.on_attributes(kind);
+    report_attributes(attributes);
+}
+
+void VisitorAdapter::report_attributes(const AttributeViews& attributes) {
+    for (const auto& attr : attributes) {
+        visitor_.on_attribute(attr.name, attr.value);
+    }
+    visitor_.on_statement_end();
+}
+
+void visit(const std::string& text, DotVisitor& visitor) {
+    visit(text.data(), text.length(), visitor);
+}
+
+void visit(const char* data, size_t size, DotVisitor& visitor) {
+    VisitorAdapter adapter(visitor);
+    DotParser(data, size).parse(adapter);
+}
+
+void visit(std::istream& in, DotVisitor& visitor) {
+    VisitorAdapter adapter(visitor);
+    DotPushParser parser(adapter);
+    std::vector<char> chunk(READ_CHUNK_SIZE);
+
+    while (in) {
+        in.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+        parser.feed(chunk.data(), static_cast<size_t>(in.gcount()));
+    }
+    parser.finish();
+}
+
+} // namespace dot
+} // namespace xdot_cpp
@@ -38,6 +38,15 @@ int main(int argc, char *argv[]) {
                                   "Run without GUI (convert only)");
     parser.addOption(noGuiOption);
     
+    QCommandLineOption lazyOption(QStringList() << "l" << "lazy",
+                                 "Decode graph geometry only as it comes into view");
+    parser.addOption(lazyOption);
+    
+    QCommandLineOption shapeBudgetOption(QStringList() << "shape-budget",
+                                        "Memory for decoded geometry with --lazy, in MB (0 for no limit)",
+                                        "MB", "0");
+    parser.addOption(shapeBudgetOption);
+    
     // Process arguments
     parser.process(app);
     
@@ -47,6 +56,8 @@ int main(int argc, char *argv[]) {
     std::cout << "Creating main window..." << std::endl;
     xdot_cpp::ui::DotWindow window;
     std::cout << "Main window created." << std::endl;
+    window.dot_widget()->set_lazy_decoding(parser.isSet(lazyOption));
+    window.dot_widget()->set_shape_budget(parser.value(shapeBudgetOption).toULongLong() * 1024 * 1024);
     
     // Load file if specified
     if (!args.isEmpty()) {
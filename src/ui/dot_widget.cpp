@@ -1,5 +1,7 @@
 #include "xdot_cpp/ui/dot_widget.h"
 #include "xdot_cpp/dot/parser.h"
+#include "xdot_cpp/dot/push_parser.h"
+#include "xdot_cpp/dot/visitor.h"
 #include "xdot_cpp/xdot/xdot_parser.h"
 #include <QApplication>
 #include <QScrollBar>
@@ -8,64 +10,119 @@
 #include <QPainterPath>
 #include <QDebug>
 #include <QProcess>
-#include <QFile>
-#include <QDir>
-#include <QTextStream>
 #include <cmath>
 
 namespace xdot_cpp {
 namespace ui {
 
+namespace {
+
+// How often decoded parts of a graph being loaded are shown
+constexpr int PUBLISH_INTERVAL_MS = 100;
+
+// How far on screen curves drawn as polylines may stray, in pixels
+constexpr double CURVE_FLATNESS_PX = 0.25;
+
+// The background, then edges (so they appear behind nodes), then nodes
+template <typename Edges, typename Nodes>
+void draw_scene(const xdot::GraphElement& graph, const Edges& edges, const Nodes& nodes, QtRenderer& renderer) {
+    const xdot::DisplayList& background = *graph.display_list();
+    for (const auto& ops : graph.background()) {
+        background.draw(ops, renderer);
+    }
+    for (const auto& edge : edges) {
+        edge->display_list().draw(edge->ops(), renderer);
+    }
+    for (const auto& node : nodes) {
+        node->display_list().draw(node->ops(), renderer);
+    }
+}
+
+} // namespace
+
 // QtRenderer implementation
-QtRenderer::QtRenderer(QPainter* painter) : painter_(painter) {}
+QtRenderer::QtRenderer(QPainter* painter) : painter_(painter), flatness_(0.0) {}
 
 void QtRenderer::draw_ellipse(const xdot::Point& center, double width, double height, const xdot::Pen& pen) {
-    painter_->setPen(create_qpen(pen));
-    painter_->setBrush(create_qbrush(pen));
+    const PenObjects& objects = pen_objects(pen);
+    painter_->setPen(objects.pen);
+    painter_->setBrush(objects.brush);
     
     QRectF rect(center.x - width/2, center.y - height/2, width, height);
     painter_->drawEllipse(rect);
 }
 
-void QtRenderer::draw_polygon(const std::vector<xdot::Point>& points, const xdot::Pen& pen) {
-    if (points.empty()) return;
+void QtRenderer::draw_polygon(const xdot::Point* points, size_t count, const xdot::Pen& pen) {
+    if (count == 0) return;
     
-    painter_->setPen(create_qpen(pen));
-    painter_->setBrush(create_qbrush(pen));
+    const PenObjects& objects = pen_objects(pen);
+    painter_->setPen(objects.pen);
+    painter_->setBrush(objects.brush);
     
     QPolygonF polygon;
-    for (const auto& point : points) {
-        polygon << QPointF(point.x, point.y);
+    polygon.reserve(static_cast<int>(count));
+    for (size_t i = 0; i < count; i++) {
+        polygon << QPointF(points[i].x, points[i].y);
     }
     
     painter_->drawPolygon(polygon);
 }
 
-void QtRenderer::draw_polyline(const std::vector<xdot::Point>& points, const xdot::Pen& pen) {
-    if (points.empty()) return;
+void QtRenderer::draw_polygon_instance(const std::vector<xdot::Point>& prototype,
+                                       const xdot::Placement& placement, const xdot::Pen& pen) {
+    if (prototype.empty()) return;
     
-    painter_->setPen(create_qpen(pen));
+    const PenObjects& objects = pen_objects(pen);
+    painter_->setPen(objects.pen);
+    painter_->setBrush(objects.brush);
+    
+    // The shared outline is placed by the painter instead of point by point
+    QTransform base = painter_->worldTransform();
+    painter_->setWorldTransform(QTransform(placement.cos, placement.sin, -placement.sin, placement.cos,
+                                           placement.offset.x, placement.offset.y) * base);
+    painter_->drawPolygon(prototype_polygon(prototype));
+    painter_->setWorldTransform(base);
+}
+
+const QPolygonF& QtRenderer::prototype_polygon(const std::vector<xdot::Point>& prototype) {
+    auto it = prototype_cache_.find(&prototype);
+    if (it == prototype_cache_.end()) {
+        QPolygonF polygon;
+        polygon.reserve(static_cast<int>(prototype.size()));
+        for (const auto& point : prototype) {
+            polygon << QPointF(point.x, point.y);
+        }
+        it = prototype_cache_.emplace(&prototype, std::move(polygon)).first;
+    }
+    return it->second;
+}
+
+void QtRenderer::draw_polyline(const xdot::Point* points, size_t count, const xdot::Pen& pen) {
+    if (count == 0) return;
+    
+    painter_->setPen(pen_objects(pen).pen);
     painter_->setBrush(Qt::NoBrush);
     
     QPolygonF polyline;
-    for (const auto& point : points) {
-        polyline << QPointF(point.x, point.y);
+    polyline.reserve(static_cast<int>(count));
+    for (size_t i = 0; i < count; i++) {
+        polyline << QPointF(points[i].x, points[i].y);
     }
     
     painter_->drawPolyline(polyline);
 }
 
-void QtRenderer::draw_bezier(const std::vector<xdot::Point>& control_points, const xdot::Pen& pen) {
-    if (control_points.size() < 4) return;
+void QtRenderer::draw_bezier(const xdot::Point* control_points, size_t count, const xdot::Pen& pen) {
+    if (count < 4) return;
     
-    painter_->setPen(create_qpen(pen));
+    painter_->setPen(pen_objects(pen).pen);
     painter_->setBrush(Qt::NoBrush);
     
     QPainterPath path;
     path.moveTo(control_points[0].x, control_points[0].y);
     
     // Draw cubic bezier curves
-    for (size_t i = 1; i + 2 < control_points.size(); i += 3) {
+    for (size_t i = 1; i + 2 < count; i += 3) {
         path.cubicTo(control_points[i].x, control_points[i].y,
                      control_points[i+1].x, control_points[i+1].y,
                      control_points[i+2].x, control_points[i+2].y);
@@ -74,12 +131,13 @@ void QtRenderer::draw_bezier(const std::vector<xdot::Point>& control_points, con
     painter_->drawPath(path);
 }
 
-void QtRenderer::draw_text(const xdot::Point& position, const std::string& text, const xdot::Pen& pen) {
-    painter_->setPen(create_qpen(pen));
-    QFont font = create_qfont(pen);
+void QtRenderer::draw_text(const xdot::Point& position, std::string_view text, const xdot::Pen& pen) {
+    const PenObjects& objects = pen_objects(pen);
+    painter_->setPen(objects.pen);
+    const QFont& font = objects.font;
     painter_->setFont(font);
     
-    QString qtext = QString::fromStdString(text);
+    QString qtext = QString::fromUtf8(text.data(), static_cast<int>(text.size()));
     QFontMetrics metrics(font);
     QRect text_rect = metrics.boundingRect(qtext);
     
@@ -91,14 +149,22 @@ void QtRenderer::draw_text(const xdot::Point& position, const std::string& text,
     painter_->drawText(QPointF(centered_x, centered_y), qtext);
 }
 
-void QtRenderer::draw_image(const xdot::Point& position, double width, double height, const std::string& path) {
-    QPixmap pixmap(QString::fromStdString(path));
+void QtRenderer::draw_image(const xdot::Point& position, double width, double height, std::string_view path) {
+    QPixmap pixmap(QString::fromUtf8(path.data(), static_cast<int>(path.size())));
     if (!pixmap.isNull()) {
         QRectF rect(position.x, position.y, width, height);
         painter_->drawPixmap(rect, pixmap, pixmap.rect());
     }
 }
 
+const QtRenderer::PenObjects& QtRenderer::pen_objects(const xdot::Pen& pen) {
+    auto it = pen_cache_.find(&pen);
+    if (it == pen_cache_.end()) {
+        it = pen_cache_.emplace(&pen, PenObjects{create_qpen(pen), create_qbrush(pen), create_qfont(pen)}).first;
+    }
+    return it->second;
+}
+
 QPen QtRenderer::create_qpen(const xdot::Pen& pen) {
     QPen qpen(create_qcolor(pen.color));
     qpen.setWidthF(pen.line_width);
@@ -142,89 +208,152 @@ QColor QtRenderer::create_qcolor(const xdot::Color& color) {
 
 // DotWidget implementation
 DotWidget::DotWidget(QWidget* parent)
-    : QGraphicsView(parent), scene_(nullptr), dragging_(false), zoom_factor_(1.0) {
+    : QGraphicsView(parent), scene_(nullptr), dragging_(false), zoom_factor_(1.0),
+      lazy_decoding_(false), shape_budget_(0), dot_process_(nullptr),
+      publish_timer_(new QTimer(this)) {
     setup_scene();
+    publish_timer_->setInterval(PUBLISH_INTERVAL_MS);
+    connect(publish_timer_, &QTimer::timeout, this, &DotWidget::publish_loaded);
     setDragMode(QGraphicsView::NoDrag);
     setRenderHint(QPainter::Antialiasing);
     setViewportUpdateMode(QGraphicsView::FullViewportUpdate);
 }
 
+DotWidget::~DotWidget() {
+    cancel_load();
+}
+
 void DotWidget::set_graph(std::shared_ptr<xdot::GraphElement> graph) {
+    cancel_load();
     graph_ = graph;
     update_scene();
 }
 
+void DotWidget::set_shape_budget(size_t bytes) {
+    shape_budget_ = bytes;
+    if (graph_) {
+        graph_->set_shape_budget(bytes);
+    }
+}
+
 void DotWidget::set_dot_code(const std::string& dot_code) {
     dot_code_ = dot_code;
+    cancel_load();
+    
+    // Statements are parsed as dot writes them and decoded on worker
+    // threads; publish_loaded() shows what is ready. Lazy decoding needs
+    // the whole graph, whose attribute values the deferred shapes are
+    // decoded from.
+    if (lazy_decoding_) {
+        dot_parser_ = std::make_unique<dot::DotPushParser>();
+    } else {
+        scene_loader_ = std::make_unique<xdot::SceneLoader>();
+        clear_highlights();
+        graph_ = scene_loader_->graph_element();
+    }
     
-    // Convert DOT to xdot format using Graphviz
-    try {
-        // Write DOT code to temporary file
-        QString temp_file = QDir::temp().filePath("xdot_temp.dot");
-        QFile file(temp_file);
-        if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-            qDebug() << "Failed to create temporary file";
-            return;
+    dot_process_ = new QProcess(this);
+    connect(dot_process_, &QProcess::readyReadStandardOutput, this, &DotWidget::on_dot_output);
+    connect(dot_process_, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+            this, &DotWidget::on_dot_finished);
+    connect(dot_process_, &QProcess::errorOccurred, this, [this](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart) {
+            qDebug() << "Failed to start Graphviz dot:" << dot_process_->errorString();
+            cancel_load();
         }
-        
-        QTextStream out(&file);
-        out << QString::fromStdString(dot_code);
-        file.close();
-        
-        // Run dot to generate xdot format
-        QProcess process;
-        process.start("dot", QStringList() << "-Txdot" << temp_file);
-        process.waitForFinished();
-        
-        if (process.exitCode() != 0) {
-            qDebug() << "Graphviz dot command failed:" << process.readAllStandardError();
-            QFile::remove(temp_file);
-            return;
+    });
+    
+    // The graph goes to dot's stdin; writes are flushed by the event loop,
+    // so neither side blocks on a full pipe
+    dot_process_->start("dot", QStringList() << "-Txdot");
+    dot_process_->write(dot_code.data(), static_cast<qint64>(dot_code.size()));
+    dot_process_->closeWriteChannel();
+    publish_timer_->start();
+}
+
+void DotWidget::on_dot_output() {
+    if (!dot_process_) return;
+    
+    QByteArray chunk = dot_process_->readAllStandardOutput();
+    try {
+        if (scene_loader_) {
+            scene_loader_->feed(chunk.constData(), static_cast<size_t>(chunk.size()));
+        } else if (dot_parser_) {
+            dot_parser_->feed(chunk.constData(), static_cast<size_t>(chunk.size()));
         }
-        
-        QString xdot_output = process.readAllStandardOutput();
-        QFile::remove(temp_file);
-        
-        qDebug() << "Generated xdot format successfully";
-        qDebug() << "XDot output length:" << xdot_output.length();
-        
-        // Parse the xdot format using the full parser
-        qDebug() << "About to parse xdot format...";
-        try {
-            // First parse the DOT structure
-            dot::DotParser dot_parser(xdot_output.toStdString());
-            auto dot_graph = dot_parser.parse();
-            qDebug() << "Parsed DOT structure successfully";
-            
-            // Then parse the xdot drawing commands
-            xdot::XDotParser xdot_parser(dot_graph);
+    } catch (const std::exception& e) {
+        qDebug() << "Error parsing xdot:" << e.what();
+        cancel_load();
+    }
+}
+
+void DotWidget::on_dot_finished(int exit_code, QProcess::ExitStatus exit_status) {
+    if (!dot_process_) return;
+    
+    on_dot_output();
+    if (!dot_process_) return;  // the rest of the output did not parse
+    
+    if (exit_status != QProcess::NormalExit || exit_code != 0) {
+        qDebug() << "Graphviz dot command failed:" << dot_process_->readAllStandardError();
+        cancel_load();
+        return;
+    }
+    
+    try {
+        if (scene_loader_) {
+            graph_ = scene_loader_->finish();
+        } else {
+            xdot::XDotParser xdot_parser(dot_parser_->finish());
+            xdot_parser.set_lazy(true);
+            clear_highlights();
             graph_ = xdot_parser.parse();
-            qDebug() << "Parsed xdot successfully";
+            graph_->set_shape_budget(shape_budget_);
+        }
+    } catch (const std::exception& e) {
+        qDebug() << "Error parsing xdot:" << e.what();
+    }
+    
+    cancel_load();
+    update_scene();
+}
+
+void DotWidget::publish_loaded() {
+    try {
+        if (scene_loader_ && scene_loader_->publish() > 0) {
             update_scene();
-            qDebug() << "Scene updated successfully.";
-        } catch (const std::exception& e) {
-            qDebug() << "Error parsing xdot:" << e.what();
         }
-        
     } catch (const std::exception& e) {
-        qDebug() << "Error converting DOT to xdot:" << e.what();
+        qDebug() << "Error decoding xdot:" << e.what();
+        cancel_load();
+    }
+}
+
+void DotWidget::cancel_load() {
+    publish_timer_->stop();
+    if (dot_process_) {
+        dot_process_->disconnect(this);
+        dot_process_->kill();
+        dot_process_->waitForFinished();
+        dot_process_->deleteLater();
+        dot_process_ = nullptr;
     }
+    scene_loader_.reset();
+    dot_parser_.reset();
 }
 
 void DotWidget::set_xdot_code(const std::string& xdot_code) {
+    cancel_load();
     // Parse xdot code directly
     try {
         qDebug() << "Starting xdot parsing...";
+        // Create a simple graph element with background shapes
+        graph_ = std::make_shared<xdot::GraphElement>();
         xdot::XDotAttrParser parser(xdot_code);
         qDebug() << "Created parser, about to parse...";
-        auto shapes = parser.parse();
-        qDebug() << "Parsed" << shapes.size() << "shapes";
+        xdot::OpRange ops = parser.parse(*graph_->display_list());
+        qDebug() << "Parsed" << ops.size() << "shapes";
         
-        // Create a simple graph element with background shapes
-        graph_ = std::make_shared<xdot::GraphElement>();
-        for (auto& shape : shapes) {
-            graph_->add_background_shape(shape);
-        }
+        graph_->add_background(ops);
         qDebug() << "Added shapes to graph, about to update scene...";
         
         update_scene();
@@ -306,7 +435,7 @@ void DotWidget::mousePressEvent(QMouseEvent* event) {
         xdot::Point graph_pos = qt_to_graph_coords(event->pos());
         
         if (graph_) {
-            auto node = graph_->find_node_at(graph_pos);
+            auto node = graph_->find_node_at(graph_pos, curve_flatness());
             if (node) {
                 emit node_clicked(QString::fromStdString(node->id()), 
                                 QString::fromStdString(node->url()));
@@ -314,7 +443,7 @@ void DotWidget::mousePressEvent(QMouseEvent* event) {
                 return;
             }
             
-            auto edge = graph_->find_edge_at(graph_pos);
+            auto edge = graph_->find_edge_at(graph_pos, curve_flatness());
             if (edge) {
                 emit edge_clicked(QString::fromStdString(edge->source()),
                                 QString::fromStdString(edge->target()),
@@ -391,6 +520,20 @@ void DotWidget::resizeEvent(QResizeEvent* event) {
     QGraphicsView::resizeEvent(event);
 }
 
+void DotWidget::drawBackground(QPainter* painter, const QRectF& rect) {
+    QGraphicsView::drawBackground(painter, rect);
+    
+    if (draws_visible_only()) {
+        render_visible(painter, rect);
+    }
+}
+
+bool DotWidget::draws_visible_only() const {
+    // Graphs with deferred shapes, and graphs still loading, are drawn per
+    // exposed area instead of into one pixmap
+    return graph_ && (graph_->has_deferred_shapes() || scene_loader_);
+}
+
 void DotWidget::update_scene() {
     if (scene_) {
         scene_->clear();
@@ -420,6 +563,13 @@ void DotWidget::render_graph() {
         return;
     }
     
+    if (draws_visible_only()) {
+        // Drawn by drawBackground() as parts come into view
+        scene_->setSceneRect(bbox.x1 - 10, bbox.y1 - 10, bbox.width() + 20, bbox.height() + 20);
+        viewport()->update();
+        return;
+    }
+    
     QPixmap pixmap(static_cast<int>(bbox.width() + 20), static_cast<int>(bbox.height() + 20));
     pixmap.fill(Qt::white);
     
@@ -428,25 +578,7 @@ void DotWidget::render_graph() {
     painter.translate(-bbox.x1 + 10, -bbox.y1 + 10);
     
     QtRenderer renderer(&painter);
-    
-    // Render background shapes
-    for (const auto& shape : graph_->background_shapes()) {
-        shape->draw(&renderer);
-    }
-    
-    // Render edges first (so they appear behind nodes)
-    for (const auto& edge : graph_->edges()) {
-        for (const auto& shape : edge->shapes()) {
-            shape->draw(&renderer);
-        }
-    }
-    
-    // Render nodes
-    for (const auto& node : graph_->nodes()) {
-        for (const auto& shape : node->shapes()) {
-            shape->draw(&renderer);
-        }
-    }
+    draw_scene(*graph_, graph_->edges(), graph_->nodes(), renderer);
     
     painter.end();
     
@@ -457,25 +589,37 @@ void DotWidget::render_graph() {
     scene_->setSceneRect(bbox.x1 - 10, bbox.y1 - 10, bbox.width() + 20, bbox.height() + 20);
 }
 
-void DotWidget::render_shapes(const std::vector<std::shared_ptr<xdot::Shape>>& shapes, QPainter* painter) {
+void DotWidget::render_visible(QPainter* painter, const QRectF& rect) {
+    xdot::BoundingBox visible(rect.left(), rect.top(), rect.right(), rect.bottom());
     QtRenderer renderer(painter);
-    for (const auto& shape : shapes) {
-        shape->draw(&renderer);
-    }
+    // Hit tests flatten curves with the same tolerance, so the two share
+    // one cached polyline per curve
+    renderer.set_flatness(curve_flatness());
+    
+    // Elements outside the exposed area are skipped without decoding
+    // their shapes
+    draw_scene(*graph_, graph_->find_edges_in(visible), graph_->find_nodes_in(visible), renderer);
+    // Counts the curves flattened for drawing against the shape budget
+    graph_->shape_cache()->update();
+}
+
+double DotWidget::curve_flatness() const {
+    double scale = std::hypot(transform().m11(), transform().m12());
+    return scale > 0.0 ? CURVE_FLATNESS_PX / scale : xdot::DisplayList::HIT_FLATNESS;
 }
 
 std::shared_ptr<xdot::GraphNode> DotWidget::find_node_at_position(const QPoint& pos) {
     if (!graph_) return nullptr;
     
     xdot::Point graph_pos = qt_to_graph_coords(pos);
-    return graph_->find_node_at(graph_pos);
+    return graph_->find_node_at(graph_pos, curve_flatness());
 }
 
 std::shared_ptr<xdot::GraphEdge> DotWidget::find_edge_at_position(const QPoint& pos) {
     if (!graph_) return nullptr;
     
     xdot::Point graph_pos = qt_to_graph_coords(pos);
-    return graph_->find_edge_at(graph_pos);
+    return graph_->find_edge_at(graph_pos, curve_flatness());
 }
 
 void DotWidget::highlight_element_at_position(const QPoint& pos) {
@@ -2,44 +2,40 @@
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
+#include <cctype>
+#include <charconv>
 #include <cmath>
 
 namespace xdot_cpp {
 namespace xdot {
 
-std::map<std::string, Color> ColorLookup::color_map_;
+std::map<std::string, Color, std::less<>> ColorLookup::color_map_;
 
-Color Color::from_hex(const std::string& hex) {
-    std::string hex_str = hex;
-    if (hex_str[0] == '#') {
-        hex_str = hex_str.substr(1);
+Color Color::from_hex(std::string_view hex) {
+    if (!hex.empty() && hex[0] == '#') {
+        hex.remove_prefix(1);
     }
     
-    if (hex_str.length() == 3) {
-        // Short form: #RGB -> #RRGGBB
-        hex_str = std::string(2, hex_str[0]) + 
-                  std::string(2, hex_str[1]) + 
-                  std::string(2, hex_str[2]);
+    // Short form: #RGB -> #RRGGBB
+    char expanded[6];
+    if (hex.length() == 3) {
+        for (size_t i = 0; i < 3; i++) {
+            expanded[2 * i] = expanded[2 * i + 1] = hex[i];
+        }
+        hex = std::string_view(expanded, 6);
     }
     
-    if (hex_str.length() != 6) {
+    if (hex.length() != 6) {
         return Color(); // Return black for invalid input
     }
     
-    unsigned int r, g, b;
-    std::stringstream ss;
-    ss << std::hex << hex_str.substr(0, 2);
-    ss >> r;
-    ss.clear();
-    ss.str("");
-    ss << std::hex << hex_str.substr(2, 2);
-    ss >> g;
-    ss.clear();
-    ss.str("");
-    ss << std::hex << hex_str.substr(4, 2);
-    ss >> b;
+    unsigned int channels[3] = {0, 0, 0};
+    for (size_t i = 0; i < 3; i++) {
+        const char* first = hex.data() + 2 * i;
+        std::from_chars(first, first + 2, channels[i], 16);
+    }
     
-    return Color(r / 255.0, g / 255.0, b / 255.0);
+    return Color(channels[0] / 255.0, channels[1] / 255.0, channels[2] / 255.0);
 }
 
 Color Color::from_hsv(double h, double s, double v) {
@@ -99,18 +95,28 @@ void Color::to_hsv(double& h, double& s, double& v) const {
     if (h < 0) h += 360;
 }
 
-Color ColorLookup::lookup_color(const std::string& color_spec) {
+Color ColorLookup::lookup_color(std::string_view color_spec) {
     if (color_map_.empty()) {
         init_color_map();
     }
-    
-    std::string spec = color_spec;
-    std::transform(spec.begin(), spec.end(), spec.begin(), ::tolower);
+    if (color_spec.empty()) {
+        return Color();
+    }
     
     // Try hex color first
-    if (spec[0] == '#') {
-        return Color::from_hex(spec);
+    if (color_spec[0] == '#') {
+        return Color::from_hex(color_spec);
+    }
+    
+    // Lower-case on the stack; no known name is longer than the buffer
+    char buffer[32];
+    if (color_spec.length() > sizeof(buffer)) {
+        return Color();
+    }
+    for (size_t i = 0; i < color_spec.length(); i++) {
+        buffer[i] = static_cast<char>(std::tolower(static_cast<unsigned char>(color_spec[i])));
     }
+    std::string_view spec(buffer, color_spec.length());
     
     // Try named color
     auto it = color_map_.find(spec);
@@ -0,0 +1,238 @@
+#include "xdot_cpp/xdot/display_list.h"
+#include <algorithm>
+#include <atomic>
+#include <utility>
+
+namespace xdot_cpp {
+namespace xdot {
+
+namespace {
+
+// Finer cached flattenings than this many times the requested tolerance
+// are redone rather than drawn with needless points
+constexpr double MAX_FLATNESS_RATIO = 8.0;
+
+template <typename T>
+size_t capacity_bytes(const std::vector<T>& values) {
+    return values.capacity() * sizeof(T);
+}
+
+} // namespace
+
+DisplayList::DisplayList(std::shared_ptr<PenPool> pens, std::shared_ptr<PrototypePool> prototypes)
+    : pens_(std::move(pens)), prototypes_(std::move(prototypes)) {
+    point_offsets_.push_back(0);
+    string_offsets_.push_back(0);
+}
+
+std::string_view DisplayList::string(size_t i) const {
+    uint32_t first = string_offsets_[indices_[i]];
+    return std::string_view(strings_).substr(first, string_offsets_[indices_[i] + 1] - first);
+}
+
+Placement DisplayList::placement(size_t i) const {
+    const Point* op_points = points(i);
+    Placement placement;
+    placement.cos = op_points[0].x;
+    placement.sin = op_points[0].y;
+    placement.offset = op_points[1];
+    return placement;
+}
+
+void DisplayList::add(DrawOp op, const Point* points, size_t count, const Pen* pen, uint32_t index) {
+    ops_.push_back(op);
+    op_pens_.push_back(pen);
+    points_.insert(points_.end(), points, points + count);
+    point_offsets_.push_back(static_cast<uint32_t>(points_.size()));
+    indices_.push_back(index);
+}
+
+uint32_t DisplayList::add_string(std::string_view value) {
+    strings_.append(value);
+    string_offsets_.push_back(static_cast<uint32_t>(strings_.size()));
+    return static_cast<uint32_t>(string_offsets_.size() - 2);
+}
+
+void DisplayList::add_ellipse(const Point& center, Coord width, Coord height, const Pen* pen) {
+    const Point points[] = {center, Point(width, height)};
+    add(DrawOp::ELLIPSE, points, 2, pen);
+}
+
+void DisplayList::add_polygon(const Point* points, size_t count, const Pen* pen) {
+    // Congruent polygons share the points of their prototype and only
+    // store where it is placed
+    Placement placement;
+    PrototypeIndex prototype = prototypes_->intern(points, count, placement);
+    const Point placed[] = {Point(placement.cos, placement.sin), placement.offset};
+    add(DrawOp::POLYGON, placed, 2, pen, static_cast<uint32_t>(prototype_entries_.size()));
+    prototype_entries_.push_back(&(*prototypes_)[prototype]);
+}
+
+void DisplayList::add_polyline(const Point* points, size_t count, const Pen* pen) {
+    add(DrawOp::POLYLINE, points, count, pen);
+}
+
+void DisplayList::add_bezier(const Point* control_points, size_t count, const Pen* pen) {
+    add(DrawOp::BEZIER, control_points, count, pen, static_cast<uint32_t>(flattened_.size()));
+    flattened_.emplace_back();
+}
+
+void DisplayList::add_text(const Point& position, std::string_view text, const Pen* pen) {
+    add(DrawOp::TEXT, &position, 1, pen, add_string(text));
+}
+
+void DisplayList::add_image(const Point& position, Coord width, Coord height, std::string_view path) {
+    const Point points[] = {position, Point(width, height)};
+    // Images draw without a pen
+    add(DrawOp::IMAGE, points, 2, pens_->default_pen(), add_string(path));
+}
+
+void DisplayList::shrink_to_fit() {
+    ops_.shrink_to_fit();
+    op_pens_.shrink_to_fit();
+    point_offsets_.shrink_to_fit();
+    indices_.shrink_to_fit();
+    points_.shrink_to_fit();
+    strings_.shrink_to_fit();
+    string_offsets_.shrink_to_fit();
+    prototype_entries_.shrink_to_fit();
+    flattened_.shrink_to_fit();
+}
+
+BoundingBox DisplayList::op_bounds(size_t i) const {
+    const Point* op_points = points(i);
+
+    switch (ops_[i]) {
+        case DrawOp::ELLIPSE: {
+            double half_width = op_points[1].x / 2.0;
+            double half_height = op_points[1].y / 2.0;
+            return BoundingBox(op_points[0].x - half_width, op_points[0].y - half_height,
+                               op_points[0].x + half_width, op_points[0].y + half_height);
+        }
+        case DrawOp::POLYGON: {
+            const std::vector<Point>& local = prototype(i);
+            if (local.empty()) {
+                return BoundingBox();
+            }
+            Placement place = placement(i);
+            Point first = place.apply(local[0]);
+            BoundingBox bbox(first.x, first.y, first.x, first.y);
+            for (size_t k = 1; k < local.size(); k++) {
+                Point p = place.apply(local[k]);
+                bbox.x1 = std::min(bbox.x1, p.x);
+                bbox.y1 = std::min(bbox.y1, p.y);
+                bbox.x2 = std::max(bbox.x2, p.x);
+                bbox.y2 = std::max(bbox.y2, p.y);
+            }
+            return bbox;
+        }
+        case DrawOp::POLYLINE:
+        case DrawOp::BEZIER:
+            return points_bounding_box(op_points, point_count(i));
+        case DrawOp::TEXT:
+            return text_bounding_box(op_points[0], string(i).length(), pen(i).font_size);
+        case DrawOp::IMAGE:
+            return BoundingBox(op_points[0].x, op_points[0].y,
+                               op_points[0].x + op_points[1].x, op_points[0].y + op_points[1].y);
+    }
+    return BoundingBox();
+}
+
+double DisplayList::op_hit_margin(size_t i) const {
+    switch (ops_[i]) {
+        case DrawOp::POLYLINE:
+            return pen(i).line_width + 2.0;
+        case DrawOp::BEZIER:
+            return pen(i).line_width + 5.0;
+        default:
+            return 0.0;
+    }
+}
+
+bool DisplayList::op_contains(size_t i, const Point& p, double flatness) const {
+    const Point* op_points = points(i);
+    size_t count = point_count(i);
+
+    switch (ops_[i]) {
+        case DrawOp::ELLIPSE:
+            return ellipse_contains(op_points[0], op_points[1].x, op_points[1].y, p);
+        case DrawOp::POLYGON: {
+            // Tested in prototype coordinates instead of placing every vertex
+            const std::vector<Point>& local = prototype(i);
+            return polygon_contains(local.data(), local.size(), placement(i).unapply(p));
+        }
+        case DrawOp::POLYLINE:
+            return polyline_near(op_points, count, p, op_hit_margin(i));
+        case DrawOp::BEZIER:
+            // Distance to the curve itself, not to the control points
+            return bezier_near(op_points, count, *flattened(i, flatness), p, op_hit_margin(i));
+        case DrawOp::TEXT:
+        case DrawOp::IMAGE:
+            return op_bounds(i).contains(p);
+    }
+    return false;
+}
+
+BoundingBox DisplayList::bounds(OpRange ops) const {
+    if (ops.empty()) {
+        return BoundingBox();
+    }
+
+    BoundingBox bbox = op_bounds(ops.first);
+    for (uint32_t i = ops.first + 1; i < ops.end; i++) {
+        BoundingBox op_bbox = op_bounds(i);
+        bbox.x1 = std::min(bbox.x1, op_bbox.x1);
+        bbox.y1 = std::min(bbox.y1, op_bbox.y1);
+        bbox.x2 = std::max(bbox.x2, op_bbox.x2);
+        bbox.y2 = std::max(bbox.y2, op_bbox.y2);
+    }
+    return bbox;
+}
+
+double DisplayList::hit_margin(OpRange ops) const {
+    double margin = 0.0;
+    for (uint32_t i = ops.first; i < ops.end; i++) {
+        margin = std::max(margin, op_hit_margin(i));
+    }
+    return margin;
+}
+
+bool DisplayList::contains(OpRange ops, const Point& p, double flatness) const {
+    for (uint32_t i = ops.first; i < ops.end; i++) {
+        if (op_contains(i, p, flatness)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::shared_ptr<const FlattenedBezier> DisplayList::flattened(size_t i, double tolerance) const {
+    std::shared_ptr<const FlattenedBezier>& slot = flattened_[indices_[i]];
+    auto cached = std::atomic_load(&slot);
+    if (cached && cached->tolerance <= tolerance &&
+        cached->tolerance * MAX_FLATNESS_RATIO >= tolerance) {
+        return cached;
+    }
+
+    // Racing threads may both flatten; either result is valid
+    auto fresh = std::make_shared<const FlattenedBezier>(flatten_bezier(points(i), point_count(i), tolerance));
+    std::atomic_store(&slot, fresh);
+    return fresh;
+}
+
+size_t DisplayList::memory_usage() const {
+    size_t size = sizeof(*this) + capacity_bytes(ops_) + capacity_bytes(op_pens_) +
+                  capacity_bytes(point_offsets_) + capacity_bytes(indices_) + capacity_bytes(points_) +
+                  strings_.capacity() + capacity_bytes(string_offsets_) +
+                  capacity_bytes(prototype_entries_) + capacity_bytes(flattened_);
+    for (const auto& slot : flattened_) {
+        if (auto cached = std::atomic_load(&slot)) {
+            size += sizeof(FlattenedBezier) + capacity_bytes(cached->points) +
+                    capacity_bytes(cached->segment_ends);
+        }
+    }
+    return size;
+}
+
+} // namespace xdot
+} // namespace xdot_cpp
@@ -0,0 +1,64 @@
+#include "xdot_cpp/xdot/draw_attributes.h"
+
+namespace xdot_cpp {
+namespace xdot {
+
+DrawAttributes::Slot DrawAttributes::slot_of(dot::Symbol name) {
+    switch (name) {
+        case dot::symbols::DRAW: return DRAW;
+        case dot::symbols::HDRAW: return HDRAW;
+        case dot::symbols::TDRAW: return TDRAW;
+        case dot::symbols::LDRAW: return LDRAW;
+        case dot::symbols::HLDRAW: return HLDRAW;
+        case dot::symbols::TLDRAW: return TLDRAW;
+        case dot::symbols::URL: return URL;
+        default: return NO_SLOT;
+    }
+}
+
+DrawAttributes::Slot DrawAttributes::slot_of(std::string_view name) {
+    if (name == "URL") {
+        return URL;
+    }
+    // Drawing attributes are "_draw_" with an optional one or two letter
+    // prefix
+    if (name.size() < 6 || name.size() > 8 || name.front() != '_' ||
+        name.substr(name.size() - 5) != "draw_") {
+        return NO_SLOT;
+    }
+    std::string_view prefix = name.substr(1, name.size() - 6);
+    if (prefix.empty()) return DRAW;
+    if (prefix == "h") return HDRAW;
+    if (prefix == "t") return TDRAW;
+    if (prefix == "l") return LDRAW;
+    if (prefix == "hl") return HLDRAW;
+    if (prefix == "tl") return TLDRAW;
+    return NO_SLOT;
+}
+
+void DrawAttributes::classify(const dot::AttributeList& attributes) {
+    for (const auto& attr : attributes) {
+        Slot slot = slot_of(attr.name);
+        if (slot != NO_SLOT) {
+            values[slot] = attr.value;
+        }
+    }
+}
+
+DrawAttributes DrawAttributes::of(const dot::AttributeList& attributes, const dot::AttributeSet& defaults) {
+    DrawAttributes draw;
+    if (defaults) {
+        draw.classify(*defaults);
+    }
+    draw.classify(attributes);
+    return draw;
+}
+
+DrawAttributes DrawAttributes::of(const dot::AttributeList& attributes) {
+    DrawAttributes draw;
+    draw.classify(attributes);
+    return draw;
+}
+
+} // namespace xdot
+} // namespace xdot_cpp
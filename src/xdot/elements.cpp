@@ -1,4 +1,5 @@
 #include "xdot_cpp/xdot/elements.h"
+#include "xdot_cpp/xdot/geometry.h"
 #include <algorithm>
 #include <cmath>
 
@@ -14,235 +15,148 @@ bool BoundingBox::intersects(const BoundingBox& other) const {
     return !(x2 < other.x1 || x1 > other.x2 || y2 < other.y1 || y1 > other.y2);
 }
 
-// EllipseShape implementation
-EllipseShape::EllipseShape(const Point& center, double width, double height, const Pen& pen)
-    : center_(center), width_(width), height_(height) {
-    pen_ = pen;
-}
-
-BoundingBox EllipseShape::bounding_box() const {
-    double half_width = width_ / 2.0;
-    double half_height = height_ / 2.0;
-    return BoundingBox(center_.x - half_width, center_.y - half_height,
-                       center_.x + half_width, center_.y + half_height);
-}
-
-bool EllipseShape::contains_point(const Point& p) const {
-    double dx = (p.x - center_.x) / (width_ / 2.0);
-    double dy = (p.y - center_.y) / (height_ / 2.0);
-    return (dx * dx + dy * dy) <= 1.0;
+BoundingBox points_bounding_box(const Point* points, size_t count) {
+    if (count == 0) {
+        return BoundingBox();
+    }
+    return geometry::points_bounds(points, count);
 }
 
-void EllipseShape::draw(Renderer* renderer) const {
-    renderer->draw_ellipse(center_, width_, height_, pen_);
+bool polygon_contains(const Point* points, size_t count, const Point& p) {
+    return geometry::polygon_contains(points, count, p);
 }
 
-// PolygonShape implementation
-PolygonShape::PolygonShape(const std::vector<Point>& points, const Pen& pen)
-    : points_(points) {
-    pen_ = pen;
+bool polyline_near(const Point* points, size_t count, const Point& p, double tolerance) {
+    return geometry::polyline_near(points, count, p, tolerance);
 }
 
-BoundingBox PolygonShape::bounding_box() const {
-    if (points_.empty()) {
-        return BoundingBox();
-    }
-    
-    double min_x = points_[0].x, max_x = points_[0].x;
-    double min_y = points_[0].y, max_y = points_[0].y;
-    
-    for (const auto& point : points_) {
-        min_x = std::min(min_x, point.x);
-        max_x = std::max(max_x, point.x);
-        min_y = std::min(min_y, point.y);
-        max_y = std::max(max_y, point.y);
-    }
-    
-    return BoundingBox(min_x, min_y, max_x, max_y);
+bool points_near(const Point* points, size_t count, const Point& p, double tolerance) {
+    return geometry::points_near(points, count, p, tolerance);
 }
 
-bool PolygonShape::contains_point(const Point& p) const {
-    if (points_.size() < 3) return false;
-    
-    // Ray casting algorithm
-    bool inside = false;
-    size_t j = points_.size() - 1;
-    
-    for (size_t i = 0; i < points_.size(); i++) {
-        if (((points_[i].y > p.y) != (points_[j].y > p.y)) &&
-            (p.x < (points_[j].x - points_[i].x) * (p.y - points_[i].y) / 
-                   (points_[j].y - points_[i].y) + points_[i].x)) {
-            inside = !inside;
-        }
-        j = i;
-    }
-    
-    return inside;
+bool ellipse_contains(const Point& center, double width, double height, const Point& p) {
+    double dx = (p.x - center.x) / (width / 2.0);
+    double dy = (p.y - center.y) / (height / 2.0);
+    return (dx * dx + dy * dy) <= 1.0;
 }
 
-void PolygonShape::draw(Renderer* renderer) const {
-    renderer->draw_polygon(points_, pen_);
-}
+namespace {
 
-// PolylineShape implementation
-PolylineShape::PolylineShape(const std::vector<Point>& points, const Pen& pen)
-    : points_(points) {
-    pen_ = pen;
-}
+// Deepest subdivision of one cubic segment, at most 2^16 pieces
+constexpr int MAX_FLATTEN_DEPTH = 16;
 
-BoundingBox PolylineShape::bounding_box() const {
-    if (points_.empty()) {
-        return BoundingBox();
+// Appends the points after c[0] of a polyline within tolerance of the cubic
+void flatten_cubic(const Point* c, double tolerance, int depth, std::vector<Point>& out) {
+    // Bound on the distance between the curve and its chord
+    double ux = 3.0 * c[1].x - 2.0 * c[0].x - c[3].x;
+    double uy = 3.0 * c[1].y - 2.0 * c[0].y - c[3].y;
+    double vx = 3.0 * c[2].x - c[0].x - 2.0 * c[3].x;
+    double vy = 3.0 * c[2].y - c[0].y - 2.0 * c[3].y;
+    double flatness = std::max(ux * ux, vx * vx) + std::max(uy * uy, vy * vy);
+    if (depth >= MAX_FLATTEN_DEPTH || flatness <= 16.0 * tolerance * tolerance) {
+        out.push_back(c[3]);
+        return;
     }
     
-    double min_x = points_[0].x, max_x = points_[0].x;
-    double min_y = points_[0].y, max_y = points_[0].y;
-    
-    for (const auto& point : points_) {
-        min_x = std::min(min_x, point.x);
-        max_x = std::max(max_x, point.x);
-        min_y = std::min(min_y, point.y);
-        max_y = std::max(max_y, point.y);
+    // de Casteljau split at t = 0.5
+    Point ab((c[0].x + c[1].x) / 2, (c[0].y + c[1].y) / 2);
+    Point bc((c[1].x + c[2].x) / 2, (c[1].y + c[2].y) / 2);
+    Point cd((c[2].x + c[3].x) / 2, (c[2].y + c[3].y) / 2);
+    Point abc((ab.x + bc.x) / 2, (ab.y + bc.y) / 2);
+    Point bcd((bc.x + cd.x) / 2, (bc.y + cd.y) / 2);
+    Point mid((abc.x + bcd.x) / 2, (abc.y + bcd.y) / 2);
+    const Point first[] = {c[0], ab, abc, mid};
+    const Point second[] = {mid, bcd, cd, c[3]};
+    flatten_cubic(first, tolerance, depth + 1, out);
+    flatten_cubic(second, tolerance, depth + 1, out);
+}
+
+// Whether p is within distance of the control polygon's bounding box,
+// which contains the segment
+bool segment_may_be_near(const Point* c, const Point& p, double distance) {
+    BoundingBox box = points_bounding_box(c, 4);
+    return p.x >= box.x1 - distance && p.x <= box.x2 + distance &&
+           p.y >= box.y1 - distance && p.y <= box.y2 + distance;
+}
+
+} // namespace
+
+FlattenedBezier flatten_bezier(const Point* control_points, size_t count, double tolerance) {
+    FlattenedBezier flattened;
+    flattened.tolerance = tolerance;
+    if (count == 0) {
+        return flattened;
     }
     
-    return BoundingBox(min_x, min_y, max_x, max_y);
+    flattened.points.push_back(control_points[0]);
+    for (size_t i = 0; i + 3 < count; i += 3) {
+        flatten_cubic(control_points + i, tolerance, 0, flattened.points);
+        flattened.segment_ends.push_back(static_cast<uint32_t>(flattened.points.size() - 1));
+    }
+    return flattened;
 }
 
-bool PolylineShape::contains_point(const Point& p) const {
-    // For polylines, check if point is close to any line segment
-    const double tolerance = pen_.line_width + 2.0;
+bool bezier_near(const Point* control_points, size_t count, const FlattenedBezier& flattened,
+                 const Point& p, double distance) {
+    if (count < 4) {
+        return points_near(control_points, count, p, distance);
+    }
     
-    for (size_t i = 0; i < points_.size() - 1; i++) {
-        const Point& p1 = points_[i];
-        const Point& p2 = points_[i + 1];
-        
-        // Distance from point to line segment
-        double A = p.x - p1.x;
-        double B = p.y - p1.y;
-        double C = p2.x - p1.x;
-        double D = p2.y - p1.y;
-        
-        double dot = A * C + B * D;
-        double len_sq = C * C + D * D;
-        
-        if (len_sq == 0) continue; // Degenerate line segment
-        
-        double param = dot / len_sq;
-        
-        double xx, yy;
-        if (param < 0) {
-            xx = p1.x;
-            yy = p1.y;
-        } else if (param > 1) {
-            xx = p2.x;
-            yy = p2.y;
-        } else {
-            xx = p1.x + param * C;
-            yy = p1.y + param * D;
-        }
-        
-        double dx = p.x - xx;
-        double dy = p.y - yy;
-        double distance = std::sqrt(dx * dx + dy * dy);
-        
-        if (distance <= tolerance) {
+    size_t start = 0;
+    for (size_t segment = 0; segment < flattened.segment_ends.size(); segment++) {
+        size_t end = flattened.segment_ends[segment];
+        if (segment_may_be_near(control_points + 3 * segment, p, distance) &&
+            polyline_near(flattened.points.data() + start, end - start + 1, p, distance)) {
             return true;
         }
+        start = end;
     }
-    
     return false;
 }
 
-void PolylineShape::draw(Renderer* renderer) const {
-    renderer->draw_polyline(points_, pen_);
-}
-
-// BezierShape implementation
-BezierShape::BezierShape(const std::vector<Point>& control_points, const Pen& pen)
-    : control_points_(control_points) {
-    pen_ = pen;
-}
-
-BoundingBox BezierShape::bounding_box() const {
-    if (control_points_.empty()) {
-        return BoundingBox();
-    }
-    
-    double min_x = control_points_[0].x, max_x = control_points_[0].x;
-    double min_y = control_points_[0].y, max_y = control_points_[0].y;
-    
-    for (const auto& point : control_points_) {
-        min_x = std::min(min_x, point.x);
-        max_x = std::max(max_x, point.x);
-        min_y = std::min(min_y, point.y);
-        max_y = std::max(max_y, point.y);
+bool bezier_near(const Point* control_points, size_t count, const Point& p, double distance,
+                 double tolerance) {
+    if (count < 4) {
+        return points_near(control_points, count, p, distance);
     }
     
-    return BoundingBox(min_x, min_y, max_x, max_y);
-}
-
-bool BezierShape::contains_point(const Point& p) const {
-    // Simplified: check if point is close to control points
-    const double tolerance = pen_.line_width + 5.0;
-    
-    for (const auto& cp : control_points_) {
-        double dx = p.x - cp.x;
-        double dy = p.y - cp.y;
-        if (std::sqrt(dx * dx + dy * dy) <= tolerance) {
+    std::vector<Point> segment_points;
+    for (size_t i = 0; i + 3 < count; i += 3) {
+        if (!segment_may_be_near(control_points + i, p, distance)) {
+            continue;
+        }
+        segment_points.assign(1, control_points[i]);
+        flatten_cubic(control_points + i, tolerance, 0, segment_points);
+        if (polyline_near(segment_points.data(), segment_points.size(), p, distance)) {
             return true;
         }
     }
-    
     return false;
 }
 
-void BezierShape::draw(Renderer* renderer) const {
-    renderer->draw_bezier(control_points_, pen_);
-}
-
-// TextShape implementation
-TextShape::TextShape(const Point& position, const std::string& text, const Pen& pen)
-    : position_(position), text_(text) {
-    pen_ = pen;
-}
-
-BoundingBox TextShape::bounding_box() const {
+BoundingBox text_bounding_box(const Point& position, size_t length, double font_size) {
     // Simple text bounding box estimation
-    double text_width = text_.length() * pen_.font_size * 0.6;
-    double text_height = pen_.font_size;
+    double text_width = length * font_size * 0.6;
+    double text_height = font_size;
     
     // Center the bounding box around the position
     double half_width = text_width / 2.0;
     double half_height = text_height / 2.0;
     
-    return BoundingBox(position_.x - half_width, position_.y - half_height,
-                       position_.x + half_width, position_.y + half_height);
-}
-
-bool TextShape::contains_point(const Point& p) const {
-    return bounding_box().contains(p);
-}
-
-void TextShape::draw(Renderer* renderer) const {
-    renderer->draw_text(position_, text_, pen_);
+    return BoundingBox(position.x - half_width, position.y - half_height,
+                       position.x + half_width, position.y + half_height);
 }
 
-// ImageShape implementation
-ImageShape::ImageShape(const Point& position, double width, double height, const std::string& path)
-    : position_(position), width_(width), height_(height), image_path_(path) {}
-
-BoundingBox ImageShape::bounding_box() const {
-    return BoundingBox(position_.x, position_.y, 
-                       position_.x + width_, position_.y + height_);
-}
-
-bool ImageShape::contains_point(const Point& p) const {
-    return bounding_box().contains(p);
-}
-
-void ImageShape::draw(Renderer* renderer) const {
-    renderer->draw_image(position_, width_, height_, image_path_);
+// Renderer implementation
+void Renderer::draw_polygon_instance(const std::vector<Point>& prototype, const Placement& placement,
+                                     const Pen& pen) {
+    std::vector<Point> placed;
+    placed.reserve(prototype.size());
+    for (const auto& point : prototype) {
+        placed.push_back(placement.apply(point));
+    }
+    draw_polygon(placed.data(), placed.size(), pen);
 }
 
 } // namespace xdot
-} // namespace xdot_cpp
\ No newline at end of file
+} // namespace xdot_cpp
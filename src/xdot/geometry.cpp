@@ -0,0 +1,777 @@
+#include "xdot_cpp/xdot/geometry.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define XDOT_CPP_HAVE_SSE2 1
+#endif
+#if defined(__GNUC__) || defined(__clang__)
+#define XDOT_CPP_HAVE_AVX2 1
+#endif
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace xdot_cpp {
+namespace xdot {
+namespace geometry {
+
+namespace {
+
+// The vector kernels read points as packed (x, y) pairs of Coords
+static_assert(sizeof(Point) == 2 * sizeof(Coord), "Point must be two packed coordinates");
+
+inline unsigned count_bits(unsigned mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    return static_cast<unsigned>(__popcnt(mask));
+#else
+    return static_cast<unsigned>(__builtin_popcount(mask));
+#endif
+}
+
+// Scalar kernels (also used for the tails of the vector kernels). All
+// arithmetic is in Coord and the vector kernels evaluate the same
+// expressions in the same order, so all variants agree bit for bit.
+
+inline Coord squared(double distance) {
+    Coord d = static_cast<Coord>(distance);
+    return d * d;
+}
+
+// Whether the edge from (xj, yj) to (xi, yi) crosses the ray from p to +x
+inline bool edge_crosses(Coord xi, Coord yi, Coord xj, Coord yj, const Point& p) {
+    return ((yi > p.y) != (yj > p.y)) && (p.x < (xj - xi) * (p.y - yi) / (yj - yi) + xi);
+}
+
+inline bool segment_near(Coord x1, Coord y1, Coord x2, Coord y2, const Point& p, Coord distance_sq) {
+    Coord c = x2 - x1;
+    Coord d = y2 - y1;
+    Coord len_sq = c * c + d * d;
+    if (len_sq == 0) return false;  // Degenerate segment
+
+    Coord param = ((p.x - x1) * c + (p.y - y1) * d) / len_sq;
+    param = std::min(std::max(param, Coord(0)), Coord(1));
+    Coord dx = p.x - (x1 + param * c);
+    Coord dy = p.y - (y1 + param * d);
+    return dx * dx + dy * dy <= distance_sq;
+}
+
+inline void include_point(BoundingBox& box, Coord x, Coord y) {
+    box.x1 = std::min(box.x1, x);
+    box.y1 = std::min(box.y1, y);
+    box.x2 = std::max(box.x2, x);
+    box.y2 = std::max(box.y2, y);
+}
+
+// Points [first, count) into box
+void points_bounds_scalar(const Point* points, size_t first, size_t count, BoundingBox& box) {
+    for (size_t i = first; i < count; i++) {
+        include_point(box, points[i].x, points[i].y);
+    }
+}
+
+// Boxes [first, end) into box
+void union_bounds_scalar(const BoxArrays& boxes, size_t first, size_t end, BoundingBox& box) {
+    for (size_t i = first; i < end; i++) {
+        box.x1 = std::min(box.x1, boxes.x1[i]);
+        box.y1 = std::min(box.y1, boxes.y1[i]);
+        box.x2 = std::max(box.x2, boxes.x2[i]);
+        box.y2 = std::max(box.y2, boxes.y2[i]);
+    }
+}
+
+BoundingBox union_bounds_scalar(const BoxArrays& boxes, size_t first, size_t count) {
+    BoundingBox box(boxes.x1[first], boxes.y1[first], boxes.x2[first], boxes.y2[first]);
+    union_bounds_scalar(boxes, first + 1, first + count, box);
+    return box;
+}
+
+// Folds the stored lanes of vector registers into a box. Interleaved
+// registers hold (x, y) pairs, the others one coordinate each.
+template <size_t Lanes>
+BoundingBox fold_interleaved(const Coord* low, const Coord* high) {
+    BoundingBox box(low[0], low[1], high[0], high[1]);
+    for (size_t lane = 2; lane < Lanes; lane += 2) {
+        include_point(box, low[lane], low[lane + 1]);
+        include_point(box, high[lane], high[lane + 1]);
+    }
+    return box;
+}
+
+template <size_t Lanes>
+BoundingBox fold_lanes(const Coord* x1, const Coord* y1, const Coord* x2, const Coord* y2) {
+    BoundingBox box(x1[0], y1[0], x2[0], y2[0]);
+    for (size_t lane = 1; lane < Lanes; lane++) {
+        box.x1 = std::min(box.x1, x1[lane]);
+        box.y1 = std::min(box.y1, y1[lane]);
+        box.x2 = std::max(box.x2, x2[lane]);
+        box.y2 = std::max(box.y2, y2[lane]);
+    }
+    return box;
+}
+
+uint32_t contains_mask_scalar(const BoxArrays& boxes, size_t first, size_t count, const Point& p) {
+    uint32_t mask = 0;
+    for (size_t i = 0; i < count; i++) {
+        size_t b = first + i;
+        if (boxes.x1[b] <= p.x && boxes.y1[b] <= p.y && boxes.x2[b] >= p.x && boxes.y2[b] >= p.y) {
+            mask |= 1u << i;
+        }
+    }
+    return mask;
+}
+
+uint32_t intersects_mask_scalar(const BoxArrays& boxes, size_t first, size_t count, const BoundingBox& area) {
+    uint32_t mask = 0;
+    for (size_t i = 0; i < count; i++) {
+        size_t b = first + i;
+        if (boxes.x1[b] <= area.x2 && boxes.y1[b] <= area.y2 &&
+            boxes.x2[b] >= area.x1 && boxes.y2[b] >= area.y1) {
+            mask |= 1u << i;
+        }
+    }
+    return mask;
+}
+
+// Crossings of edges (i - 1, i) for i in [first, count)
+unsigned polygon_crossings_scalar(const Point* points, size_t first, size_t count, const Point& p) {
+    unsigned crossings = 0;
+    for (size_t i = first; i < count; i++) {
+        crossings += edge_crosses(points[i].x, points[i].y, points[i - 1].x, points[i - 1].y, p);
+    }
+    return crossings;
+}
+
+// Segments (i, i + 1) for i in [first, count - 1)
+bool polyline_near_scalar(const Point* points, size_t first, size_t count, const Point& p, Coord distance_sq) {
+    for (size_t i = first; i + 1 < count; i++) {
+        if (segment_near(points[i].x, points[i].y, points[i + 1].x, points[i + 1].y, p, distance_sq)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool points_near_scalar(const Point* points, size_t first, size_t count, const Point& p, Coord distance_sq) {
+    for (size_t i = first; i < count; i++) {
+        Coord dx = p.x - points[i].x;
+        Coord dy = p.y - points[i].y;
+        if (dx * dx + dy * dy <= distance_sq) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Whole-array scalar kernels, for targets without a vector unit and for
+// pinning with XDOT_CPP_GEOMETRY_KERNELS=scalar
+
+BoundingBox points_bounds_scalar(const Point* points, size_t count) {
+    BoundingBox box(points[0].x, points[0].y, points[0].x, points[0].y);
+    points_bounds_scalar(points, 1, count, box);
+    return box;
+}
+
+bool polygon_contains_scalar(const Point* points, size_t count, const Point& p) {
+    unsigned crossings = edge_crosses(points[0].x, points[0].y, points[count - 1].x, points[count - 1].y, p);
+    crossings += polygon_crossings_scalar(points, 1, count, p);
+    return (crossings & 1) != 0;
+}
+
+bool polyline_near_scalar(const Point* points, size_t count, const Point& p, double distance) {
+    return polyline_near_scalar(points, 0, count, p, squared(distance));
+}
+
+bool points_near_scalar(const Point* points, size_t count, const Point& p, double distance) {
+    return points_near_scalar(points, 0, count, p, squared(distance));
+}
+
+#ifdef XDOT_CPP_HAVE_SSE2
+
+// An SSE register of Coords and the operations the kernels use on it, so
+// that each kernel is written once for both storage precisions
+
+#ifdef XDOT_CPP_FLOAT_GEOMETRY
+
+using Sse = __m128;
+constexpr size_t SSE_LANES = 4;
+
+inline Sse sse_set1(Coord v) { return _mm_set1_ps(v); }
+inline Sse sse_load(const Coord* data) { return _mm_loadu_ps(data); }
+inline void sse_store(Coord* data, Sse a) { _mm_storeu_ps(data, a); }
+inline Sse sse_add(Sse a, Sse b) { return _mm_add_ps(a, b); }
+inline Sse sse_sub(Sse a, Sse b) { return _mm_sub_ps(a, b); }
+inline Sse sse_mul(Sse a, Sse b) { return _mm_mul_ps(a, b); }
+inline Sse sse_div(Sse a, Sse b) { return _mm_div_ps(a, b); }
+inline Sse sse_min(Sse a, Sse b) { return _mm_min_ps(a, b); }
+inline Sse sse_max(Sse a, Sse b) { return _mm_max_ps(a, b); }
+inline Sse sse_and(Sse a, Sse b) { return _mm_and_ps(a, b); }
+inline Sse sse_xor(Sse a, Sse b) { return _mm_xor_ps(a, b); }
+inline Sse sse_le(Sse a, Sse b) { return _mm_cmple_ps(a, b); }
+inline Sse sse_lt(Sse a, Sse b) { return _mm_cmplt_ps(a, b); }
+inline Sse sse_neq(Sse a, Sse b) { return _mm_cmpneq_ps(a, b); }
+inline unsigned sse_mask(Sse a) { return static_cast<unsigned>(_mm_movemask_ps(a)); }
+
+// xs and ys of points[0..3]
+inline void load_points_sse2(const Point* points, Sse& xs, Sse& ys) {
+    const Coord* data = reinterpret_cast<const Coord*>(points);
+    Sse a = _mm_loadu_ps(data);
+    Sse b = _mm_loadu_ps(data + 4);
+    xs = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+    ys = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+}
+
+#else
+
+using Sse = __m128d;
+constexpr size_t SSE_LANES = 2;
+
+inline Sse sse_set1(Coord v) { return _mm_set1_pd(v); }
+inline Sse sse_load(const Coord* data) { return _mm_loadu_pd(data); }
+inline void sse_store(Coord* data, Sse a) { _mm_storeu_pd(data, a); }
+inline Sse sse_add(Sse a, Sse b) { return _mm_add_pd(a, b); }
+inline Sse sse_sub(Sse a, Sse b) { return _mm_sub_pd(a, b); }
+inline Sse sse_mul(Sse a, Sse b) { return _mm_mul_pd(a, b); }
+inline Sse sse_div(Sse a, Sse b) { return _mm_div_pd(a, b); }
+inline Sse sse_min(Sse a, Sse b) { return _mm_min_pd(a, b); }
+inline Sse sse_max(Sse a, Sse b) { return _mm_max_pd(a, b); }
+inline Sse sse_and(Sse a, Sse b) { return _mm_and_pd(a, b); }
+inline Sse sse_xor(Sse a, Sse b) { return _mm_xor_pd(a, b); }
+inline Sse sse_le(Sse a, Sse b) { return _mm_cmple_pd(a, b); }
+inline Sse sse_lt(Sse a, Sse b) { return _mm_cmplt_pd(a, b); }
+inline Sse sse_neq(Sse a, Sse b) { return _mm_cmpneq_pd(a, b); }
+inline unsigned sse_mask(Sse a) { return static_cast<unsigned>(_mm_movemask_pd(a)); }
+
+// xs and ys of points[0] and points[1]
+inline void load_points_sse2(const Point* points, Sse& xs, Sse& ys) {
+    const Coord* data = reinterpret_cast<const Coord*>(points);
+    Sse a = _mm_loadu_pd(data);
+    Sse b = _mm_loadu_pd(data + 2);
+    xs = _mm_unpacklo_pd(a, b);
+    ys = _mm_unpackhi_pd(a, b);
+}
+
+#endif // XDOT_CPP_FLOAT_GEOMETRY
+
+BoundingBox points_bounds_sse2(const Point* points, size_t count) {
+    // Registers hold (x, y) pairs
+    constexpr size_t PER_REGISTER = SSE_LANES / 2;
+    if (count < PER_REGISTER) {
+        BoundingBox box(points[0].x, points[0].y, points[0].x, points[0].y);
+        points_bounds_scalar(points, 1, count, box);
+        return box;
+    }
+
+    const Coord* data = reinterpret_cast<const Coord*>(points);
+    Sse low = sse_load(data);
+    Sse high = low;
+    size_t i = PER_REGISTER;
+    for (; i + PER_REGISTER <= count; i += PER_REGISTER) {
+        Sse group = sse_load(data + 2 * i);
+        low = sse_min(low, group);
+        high = sse_max(high, group);
+    }
+
+    Coord lo[SSE_LANES], hi[SSE_LANES];
+    sse_store(lo, low);
+    sse_store(hi, high);
+    BoundingBox box = fold_interleaved<SSE_LANES>(lo, hi);
+    points_bounds_scalar(points, i, count, box);
+    return box;
+}
+
+BoundingBox union_bounds_sse2(const BoxArrays& boxes, size_t first, size_t count) {
+    if (count < SSE_LANES) {
+        return union_bounds_scalar(boxes, first, count);
+    }
+
+    Sse x1 = sse_load(boxes.x1 + first);
+    Sse y1 = sse_load(boxes.y1 + first);
+    Sse x2 = sse_load(boxes.x2 + first);
+    Sse y2 = sse_load(boxes.y2 + first);
+    size_t i = first + SSE_LANES;
+    for (; i + SSE_LANES <= first + count; i += SSE_LANES) {
+        x1 = sse_min(x1, sse_load(boxes.x1 + i));
+        y1 = sse_min(y1, sse_load(boxes.y1 + i));
+        x2 = sse_max(x2, sse_load(boxes.x2 + i));
+        y2 = sse_max(y2, sse_load(boxes.y2 + i));
+    }
+
+    Coord a[SSE_LANES], b[SSE_LANES], c[SSE_LANES], d[SSE_LANES];
+    sse_store(a, x1);
+    sse_store(b, y1);
+    sse_store(c, x2);
+    sse_store(d, y2);
+    BoundingBox box = fold_lanes<SSE_LANES>(a, b, c, d);
+    union_bounds_scalar(boxes, i, first + count, box);
+    return box;
+}
+
+uint32_t contains_mask_sse2(const BoxArrays& boxes, size_t first, size_t count, const Point& p) {
+    const Sse px = sse_set1(p.x);
+    const Sse py = sse_set1(p.y);
+    uint32_t mask = 0;
+    size_t i = 0;
+    for (; i + SSE_LANES <= count; i += SSE_LANES) {
+        size_t b = first + i;
+        Sse in = sse_and(sse_le(sse_load(boxes.x1 + b), px), sse_le(sse_load(boxes.y1 + b), py));
+        in = sse_and(in, sse_le(px, sse_load(boxes.x2 + b)));
+        in = sse_and(in, sse_le(py, sse_load(boxes.y2 + b)));
+        mask |= sse_mask(in) << i;
+    }
+    if (i < count) {
+        mask |= contains_mask_scalar(boxes, first + i, count - i, p) << i;
+    }
+    return mask;
+}
+
+uint32_t intersects_mask_sse2(const BoxArrays& boxes, size_t first, size_t count, const BoundingBox& area) {
+    const Sse ax1 = sse_set1(area.x1);
+    const Sse ay1 = sse_set1(area.y1);
+    const Sse ax2 = sse_set1(area.x2);
+    const Sse ay2 = sse_set1(area.y2);
+    uint32_t mask = 0;
+    size_t i = 0;
+    for (; i + SSE_LANES <= count; i += SSE_LANES) {
+        size_t b = first + i;
+        Sse in = sse_and(sse_le(sse_load(boxes.x1 + b), ax2), sse_le(sse_load(boxes.y1 + b), ay2));
+        in = sse_and(in, sse_le(ax1, sse_load(boxes.x2 + b)));
+        in = sse_and(in, sse_le(ay1, sse_load(boxes.y2 + b)));
+        mask |= sse_mask(in) << i;
+    }
+    if (i < count) {
+        mask |= intersects_mask_scalar(boxes, first + i, count - i, area) << i;
+    }
+    return mask;
+}
+
+bool polygon_contains_sse2(const Point* points, size_t count, const Point& p) {
+    const Sse px = sse_set1(p.x);
+    const Sse py = sse_set1(p.y);
+    unsigned crossings = edge_crosses(points[0].x, points[0].y, points[count - 1].x, points[count - 1].y, p);
+    size_t i = 1;
+    for (; i + SSE_LANES <= count; i += SSE_LANES) {
+        Sse xi, yi, xj, yj;
+        load_points_sse2(points + i, xi, yi);
+        load_points_sse2(points + i - 1, xj, yj);
+        Sse straddles = sse_xor(sse_lt(py, yi), sse_lt(py, yj));
+        if (!sse_mask(straddles)) {
+            continue;
+        }
+        Sse x = sse_add(sse_div(sse_mul(sse_sub(xj, xi), sse_sub(py, yi)), sse_sub(yj, yi)), xi);
+        crossings += count_bits(sse_mask(sse_and(straddles, sse_lt(px, x))));
+    }
+    crossings += polygon_crossings_scalar(points, i, count, p);
+    return (crossings & 1) != 0;
+}
+
+bool polyline_near_sse2(const Point* points, size_t count, const Point& p, double distance) {
+    const Coord distance_sq = squared(distance);
+    const Sse px = sse_set1(p.x);
+    const Sse py = sse_set1(p.y);
+    const Sse limit = sse_set1(distance_sq);
+    const Sse zero = sse_set1(0);
+    const Sse one = sse_set1(1);
+    size_t i = 0;
+    for (; i + SSE_LANES + 1 <= count; i += SSE_LANES) {
+        Sse x1, y1, x2, y2;
+        load_points_sse2(points + i, x1, y1);
+        load_points_sse2(points + i + 1, x2, y2);
+        Sse c = sse_sub(x2, x1);
+        Sse d = sse_sub(y2, y1);
+        Sse len_sq = sse_add(sse_mul(c, c), sse_mul(d, d));
+        Sse dot = sse_add(sse_mul(sse_sub(px, x1), c), sse_mul(sse_sub(py, y1), d));
+        Sse param = sse_min(sse_max(sse_div(dot, len_sq), zero), one);
+        Sse dx = sse_sub(px, sse_add(x1, sse_mul(param, c)));
+        Sse dy = sse_sub(py, sse_add(y1, sse_mul(param, d)));
+        Sse near = sse_le(sse_add(sse_mul(dx, dx), sse_mul(dy, dy)), limit);
+        if (sse_mask(sse_and(near, sse_neq(len_sq, zero)))) {
+            return true;
+        }
+    }
+    return polyline_near_scalar(points, i, count, p, distance_sq);
+}
+
+bool points_near_sse2(const Point* points, size_t count, const Point& p, double distance) {
+    const Coord distance_sq = squared(distance);
+    const Sse px = sse_set1(p.x);
+    const Sse py = sse_set1(p.y);
+    const Sse limit = sse_set1(distance_sq);
+    size_t i = 0;
+    for (; i + SSE_LANES <= count; i += SSE_LANES) {
+        Sse xs, ys;
+        load_points_sse2(points + i, xs, ys);
+        Sse dx = sse_sub(px, xs);
+        Sse dy = sse_sub(py, ys);
+        if (sse_mask(sse_le(sse_add(sse_mul(dx, dx), sse_mul(dy, dy)), limit))) {
+            return true;
+        }
+    }
+    return points_near_scalar(points, i, count, p, distance_sq);
+}
+
+#endif // XDOT_CPP_HAVE_SSE2
+
+#ifdef XDOT_CPP_HAVE_AVX2
+
+// The AVX counterpart of the SSE operations above
+
+#ifdef XDOT_CPP_FLOAT_GEOMETRY
+
+using Avx = __m256;
+constexpr size_t AVX_LANES = 8;
+
+__attribute__((target("avx2"))) inline Avx avx_set1(Coord v) { return _mm256_set1_ps(v); }
+__attribute__((target("avx2"))) inline Avx avx_load(const Coord* data) { return _mm256_loadu_ps(data); }
+__attribute__((target("avx2"))) inline void avx_store(Coord* data, Avx a) { _mm256_storeu_ps(data, a); }
+__attribute__((target("avx2"))) inline Avx avx_add(Avx a, Avx b) { return _mm256_add_ps(a, b); }
+__attribute__((target("avx2"))) inline Avx avx_sub(Avx a, Avx b) { return _mm256_sub_ps(a, b); }
+__attribute__((target("avx2"))) inline Avx avx_mul(Avx a, Avx b) { return _mm256_mul_ps(a, b); }
+__attribute__((target("avx2"))) inline Avx avx_div(Avx a, Avx b) { return _mm256_div_ps(a, b); }
+__attribute__((target("avx2"))) inline Avx avx_min(Avx a, Avx b) { return _mm256_min_ps(a, b); }
+__attribute__((target("avx2"))) inline Avx avx_max(Avx a, Avx b) { return _mm256_max_ps(a, b); }
+__attribute__((target("avx2"))) inline Avx avx_and(Avx a, Avx b) { return _mm256_and_ps(a, b); }
+__attribute__((target("avx2"))) inline Avx avx_xor(Avx a, Avx b) { return _mm256_xor_ps(a, b); }
+__attribute__((target("avx2"))) inline Avx avx_le(Avx a, Avx b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+__attribute__((target("avx2"))) inline Avx avx_lt(Avx a, Avx b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+__attribute__((target("avx2"))) inline Avx avx_neq(Avx a, Avx b) { return _mm256_cmp_ps(a, b, _CMP_NEQ_OQ); }
+__attribute__((target("avx2"))) inline unsigned avx_mask(Avx a) {
+    return static_cast<unsigned>(_mm256_movemask_ps(a));
+}
+
+// xs and ys of points[0..7]. Lanes hold points 0, 1, 4, 5, 2, 3, 6, 7;
+// callers only pair lanes of loads with the same layout.
+__attribute__((target("avx2")))
+inline void load_points_avx2(const Point* points, Avx& xs, Avx& ys) {
+    const Coord* data = reinterpret_cast<const Coord*>(points);
+    Avx a = _mm256_loadu_ps(data);
+    Avx b = _mm256_loadu_ps(data + 8);
+    xs = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+    ys = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+}
+
+#else
+
+using Avx = __m256d;
+constexpr size_t AVX_LANES = 4;
+
+__attribute__((target("avx2"))) inline Avx avx_set1(Coord v) { return _mm256_set1_pd(v); }
+__attribute__((target("avx2"))) inline Avx avx_load(const Coord* data) { return _mm256_loadu_pd(data); }
+__attribute__((target("avx2"))) inline void avx_store(Coord* data, Avx a) { _mm256_storeu_pd(data, a); }
+__attribute__((target("avx2"))) inline Avx avx_add(Avx a, Avx b) { return _mm256_add_pd(a, b); }
+__attribute__((target("avx2"))) inline Avx avx_sub(Avx a, Avx b) { return _mm256_sub_pd(a, b); }
+__attribute__((target("avx2"))) inline Avx avx_mul(Avx a, Avx b) { return _mm256_mul_pd(a, b); }
+__attribute__((target("avx2"))) inline Avx avx_div(Avx a, Avx b) { return _mm256_div_pd(a, b); }
+__attribute__((target("avx2"))) inline Avx avx_min(Avx a, Avx b) { return _mm256_min_pd(a, b); }
+__attribute__((target("avx2"))) inline Avx avx_max(Avx a, Avx b) { return _mm256_max_pd(a, b); }
+__attribute__((target("avx2"))) inline Avx avx_and(Avx a, Avx b) { return _mm256_and_pd(a, b); }
+__attribute__((target("avx2"))) inline Avx avx_xor(Avx a, Avx b) { return _mm256_xor_pd(a, b); }
+__attribute__((target("avx2"))) inline Avx avx_le(Avx a, Avx b) { return _mm256_cmp_pd(a, b, _CMP_LE_OQ); }
+__attribute__((target("avx2"))) inline Avx avx_lt(Avx a, Avx b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+__attribute__((target("avx2"))) inline Avx avx_neq(Avx a, Avx b) { return _mm256_cmp_pd(a, b, _CMP_NEQ_OQ); }
+__attribute__((target("avx2"))) inline unsigned avx_mask(Avx a) {
+    return static_cast<unsigned>(_mm256_movemask_pd(a));
+}
+
+// xs and ys of points[0..3]. Lanes hold points 0, 2, 1, 3; callers only
+// pair lanes of loads with the same layout.
+__attribute__((target("avx2")))
+inline void load_points_avx2(const Point* points, Avx& xs, Avx& ys) {
+    const Coord* data = reinterpret_cast<const Coord*>(points);
+    Avx a = _mm256_loadu_pd(data);
+    Avx b = _mm256_loadu_pd(data + 4);
+    xs = _mm256_unpacklo_pd(a, b);
+    ys = _mm256_unpackhi_pd(a, b);
+}
+
+#endif // XDOT_CPP_FLOAT_GEOMETRY
+
+// The scalar tails are SSE encoded; the AVX kernels clear the upper
+// register halves before calling them to avoid state transition stalls
+
+__attribute__((target("avx2")))
+BoundingBox points_bounds_avx2(const Point* points, size_t count) {
+    // Registers hold (x, y) pairs
+    constexpr size_t PER_REGISTER = AVX_LANES / 2;
+    if (count < PER_REGISTER) {
+        BoundingBox box(points[0].x, points[0].y, points[0].x, points[0].y);
+        points_bounds_scalar(points, 1, count, box);
+        return box;
+    }
+
+    const Coord* data = reinterpret_cast<const Coord*>(points);
+    Avx low = avx_load(data);
+    Avx high = low;
+    size_t i = PER_REGISTER;
+    for (; i + PER_REGISTER <= count; i += PER_REGISTER) {
+        Avx group = avx_load(data + 2 * i);
+        low = avx_min(low, group);
+        high = avx_max(high, group);
+    }
+
+    Coord lo[AVX_LANES], hi[AVX_LANES];
+    avx_store(lo, low);
+    avx_store(hi, high);
+    _mm256_zeroupper();
+    BoundingBox box = fold_interleaved<AVX_LANES>(lo, hi);
+    points_bounds_scalar(points, i, count, box);
+    return box;
+}
+
+__attribute__((target("avx2")))
+BoundingBox union_bounds_avx2(const BoxArrays& boxes, size_t first, size_t count) {
+    if (count < AVX_LANES) {
+        return union_bounds_scalar(boxes, first, count);
+    }
+
+    Avx x1 = avx_load(boxes.x1 + first);
+    Avx y1 = avx_load(boxes.y1 + first);
+    Avx x2 = avx_load(boxes.x2 + first);
+    Avx y2 = avx_load(boxes.y2 + first);
+    size_t i = first + AVX_LANES;
+    for (; i + AVX_LANES <= first + count; i += AVX_LANES) {
+        x1 = avx_min(x1, avx_load(boxes.x1 + i));
+        y1 = avx_min(y1, avx_load(boxes.y1 + i));
+        x2 = avx_max(x2, avx_load(boxes.x2 + i));
+        y2 = avx_max(y2, avx_load(boxes.y2 + i));
+    }
+
+    Coord a[AVX_LANES], b[AVX_LANES], c[AVX_LANES], d[AVX_LANES];
+    avx_store(a, x1);
+    avx_store(b, y1);
+    avx_store(c, x2);
+    avx_store(d, y2);
+    _mm256_zeroupper();
+    BoundingBox box = fold_lanes<AVX_LANES>(a, b, c, d);
+    union_bounds_scalar(boxes, i, first + count, box);
+    return box;
+}
+
+__attribute__((target("avx2")))
+uint32_t contains_mask_avx2(const BoxArrays& boxes, size_t first, size_t count, const Point& p) {
+    const Avx px = avx_set1(p.x);
+    const Avx py = avx_set1(p.y);
+    uint32_t mask = 0;
+    size_t i = 0;
+    for (; i + AVX_LANES <= count; i += AVX_LANES) {
+        size_t b = first + i;
+        Avx in = avx_and(avx_le(avx_load(boxes.x1 + b), px), avx_le(avx_load(boxes.y1 + b), py));
+        in = avx_and(in, avx_le(px, avx_load(boxes.x2 + b)));
+        in = avx_and(in, avx_le(py, avx_load(boxes.y2 + b)));
+        mask |= avx_mask(in) << i;
+    }
+    if (i < count) {
+        _mm256_zeroupper();
+        mask |= contains_mask_scalar(boxes, first + i, count - i, p) << i;
+    }
+    return mask;
+}
+
+__attribute__((target("avx2")))
+uint32_t intersects_mask_avx2(const BoxArrays& boxes, size_t first, size_t count, const BoundingBox& area) {
+    const Avx ax1 = avx_set1(area.x1);
+    const Avx ay1 = avx_set1(area.y1);
+    const Avx ax2 = avx_set1(area.x2);
+    const Avx ay2 = avx_set1(area.y2);
+    uint32_t mask = 0;
+    size_t i = 0;
+    for (; i + AVX_LANES <= count; i += AVX_LANES) {
+        size_t b = first + i;
+        Avx in = avx_and(avx_le(avx_load(boxes.x1 + b), ax2), avx_le(avx_load(boxes.y1 + b), ay2));
+        in = avx_and(in, avx_le(ax1, avx_load(boxes.x2 + b)));
+        in = avx_and(in, avx_le(ay1, avx_load(boxes.y2 + b)));
+        mask |= avx_mask(in) << i;
+    }
+    if (i < count) {
+        _mm256_zeroupper();
+        mask |= intersects_mask_scalar(boxes, first + i, count - i, area) << i;
+    }
+    return mask;
+}
+
+__attribute__((target("avx2")))
+bool polygon_contains_avx2(const Point* points, size_t count, const Point& p) {
+    const Avx px = avx_set1(p.x);
+    const Avx py = avx_set1(p.y);
+    unsigned crossings = edge_crosses(points[0].x, points[0].y, points[count - 1].x, points[count - 1].y, p);
+    size_t i = 1;
+    for (; i + AVX_LANES <= count; i += AVX_LANES) {
+        Avx xi, yi, xj, yj;
+        load_points_avx2(points + i, xi, yi);
+        load_points_avx2(points + i - 1, xj, yj);
+        Avx straddles = avx_xor(avx_lt(py, yi), avx_lt(py, yj));
+        // Most edges are above or below p; skip the division for them
+        if (!avx_mask(straddles)) {
+            continue;
+        }
+        Avx x = avx_add(avx_div(avx_mul(avx_sub(xj, xi), avx_sub(py, yi)), avx_sub(yj, yi)), xi);
+        crossings += count_bits(avx_mask(avx_and(straddles, avx_lt(px, x))));
+    }
+    _mm256_zeroupper();
+    crossings += polygon_crossings_scalar(points, i, count, p);
+    return (crossings & 1) != 0;
+}
+
+__attribute__((target("avx2")))
+bool polyline_near_avx2(const Point* points, size_t count, const Point& p, double distance) {
+    const Coord distance_sq = squared(distance);
+    const Avx px = avx_set1(p.x);
+    const Avx py = avx_set1(p.y);
+    const Avx limit = avx_set1(distance_sq);
+    const Avx zero = avx_set1(0);
+    const Avx one = avx_set1(1);
+    size_t i = 0;
+    for (; i + AVX_LANES + 1 <= count; i += AVX_LANES) {
+        Avx x1, y1, x2, y2;
+        load_points_avx2(points + i, x1, y1);
+        load_points_avx2(points + i + 1, x2, y2);
+        Avx c = avx_sub(x2, x1);
+        Avx d = avx_sub(y2, y1);
+        Avx len_sq = avx_add(avx_mul(c, c), avx_mul(d, d));
+        Avx dot = avx_add(avx_mul(avx_sub(px, x1), c), avx_mul(avx_sub(py, y1), d));
+        Avx param = avx_min(avx_max(avx_div(dot, len_sq), zero), one);
+        Avx dx = avx_sub(px, avx_add(x1, avx_mul(param, c)));
+        Avx dy = avx_sub(py, avx_add(y1, avx_mul(param, d)));
+        Avx near = avx_le(avx_add(avx_mul(dx, dx), avx_mul(dy, dy)), limit);
+        if (avx_mask(avx_and(near, avx_neq(len_sq, zero)))) {
+            return true;
+        }
+    }
+    _mm256_zeroupper();
+    return polyline_near_scalar(points, i, count, p, distance_sq);
+}
+
+__attribute__((target("avx2")))
+bool points_near_avx2(const Point* points, size_t count, const Point& p, double distance) {
+    const Coord distance_sq = squared(distance);
+    const Avx px = avx_set1(p.x);
+    const Avx py = avx_set1(p.y);
+    const Avx limit = avx_set1(distance_sq);
+    size_t i = 0;
+    for (; i + AVX_LANES <= count; i += AVX_LANES) {
+        Avx xs, ys;
+        load_points_avx2(points + i, xs, ys);
+        Avx dx = avx_sub(px, xs);
+        Avx dy = avx_sub(py, ys);
+        if (avx_mask(avx_le(avx_add(avx_mul(dx, dx), avx_mul(dy, dy)), limit))) {
+            return true;
+        }
+    }
+    _mm256_zeroupper();
+    return points_near_scalar(points, i, count, p, distance_sq);
+}
+
+#endif // XDOT_CPP_HAVE_AVX2
+
+struct GeometryKernels {
+    BoundingBox (*points_bounds)(const Point*, size_t);
+    BoundingBox (*union_bounds)(const BoxArrays&, size_t, size_t);
+    uint32_t (*contains_mask)(const BoxArrays&, size_t, size_t, const Point&);
+    uint32_t (*intersects_mask)(const BoxArrays&, size_t, size_t, const BoundingBox&);
+    bool (*polygon_contains)(const Point*, size_t, const Point&);
+    bool (*polyline_near)(const Point*, size_t, const Point&, double);
+    bool (*points_near)(const Point*, size_t, const Point&, double);
+    const char* name;
+};
+
+const GeometryKernels SCALAR_KERNELS = {
+    points_bounds_scalar, union_bounds_scalar, contains_mask_scalar, intersects_mask_scalar,
+    polygon_contains_scalar, polyline_near_scalar, points_near_scalar, "scalar"};
+#ifdef XDOT_CPP_HAVE_SSE2
+const GeometryKernels SSE2_KERNELS = {
+    points_bounds_sse2, union_bounds_sse2, contains_mask_sse2, intersects_mask_sse2,
+    polygon_contains_sse2, polyline_near_sse2, points_near_sse2, "sse2"};
+#endif
+#ifdef XDOT_CPP_HAVE_AVX2
+const GeometryKernels AVX2_KERNELS = {
+    points_bounds_avx2, union_bounds_avx2, contains_mask_avx2, intersects_mask_avx2,
+    polygon_contains_avx2, polyline_near_avx2, points_near_avx2, "avx2"};
+#endif
+
+// Kernel set called name, or null if it is not built in or the CPU lacks it
+const GeometryKernels* find_kernels(const char* name) {
+#ifdef XDOT_CPP_HAVE_AVX2
+    __builtin_cpu_init();
+    if (std::strcmp(name, "avx2") == 0 && __builtin_cpu_supports("avx2")) {
+        return &AVX2_KERNELS;
+    }
+#endif
+#ifdef XDOT_CPP_HAVE_SSE2
+    if (std::strcmp(name, "sse2") == 0) {
+        return &SSE2_KERNELS;
+    }
+#endif
+    if (std::strcmp(name, "scalar") == 0) {
+        return &SCALAR_KERNELS;
+    }
+    return nullptr;
+}
+
+GeometryKernels select_kernels() {
+    if (const char* pinned = std::getenv("XDOT_CPP_GEOMETRY_KERNELS")) {
+        if (const GeometryKernels* found = find_kernels(pinned)) {
+            return *found;
+        }
+    }
+    for (const char* name : {"avx2", "sse2"}) {
+        if (const GeometryKernels* found = find_kernels(name)) {
+            return *found;
+        }
+    }
+    return SCALAR_KERNELS;
+}
+
+GeometryKernels kernels = select_kernels();
+
+} // namespace
+
+BoundingBox points_bounds(const Point* points, size_t count) {
+    return kernels.points_bounds(points, count);
+}
+
+BoundingBox union_bounds(const BoxArrays& boxes, size_t first, size_t count) {
+    return kernels.union_bounds(boxes, first, count);
+}
+
+uint32_t contains_mask(const BoxArrays& boxes, size_t first, size_t count, const Point& p) {
+    return kernels.contains_mask(boxes, first, count, p);
+}
+
+uint32_t intersects_mask(const BoxArrays& boxes, size_t first, size_t count, const BoundingBox& area) {
+    return kernels.intersects_mask(boxes, first, count, area);
+}
+
+bool polygon_contains(const Point* points, size_t count, const Point& p) {
+    if (count < 3) return false;
+    return kernels.polygon_contains(points, count, p);
+}
+
+bool polyline_near(const Point* points, size_t count, const Point& p, double distance) {
+    return kernels.polyline_near(points, count, p, distance);
+}
+
+bool points_near(const Point* points, size_t count, const Point& p, double distance) {
+    return kernels.points_near(points, count, p, distance);
+}
+
+const char* kernel_name() {
+    return kernels.name;
+}
+
+bool use_kernels(const char* name) {
+    const GeometryKernels* found = find_kernels(name);
+    if (!found) {
+        return false;
+    }
+    kernels = *found;
+    return true;
+}
+
+} // namespace geometry
+} // namespace xdot
+} // namespace xdot_cpp
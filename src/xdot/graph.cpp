@@ -1,157 +1,212 @@
 #include "xdot_cpp/xdot/graph.h"
 #include <algorithm>
+#include <functional>
 
 namespace xdot_cpp {
 namespace xdot {
 
-// GraphNode implementation
-GraphNode::GraphNode(const std::string& id, const std::vector<std::shared_ptr<Shape>>& shapes)
-    : id_(id), shapes_(shapes), highlighted_(false) {}
+namespace {
 
-BoundingBox GraphNode::bounding_box() const {
-    if (shapes_.empty()) {
-        return BoundingBox();
-    }
-    
-    BoundingBox bbox = shapes_[0]->bounding_box();
-    for (size_t i = 1; i < shapes_.size(); i++) {
-        BoundingBox shape_bbox = shapes_[i]->bounding_box();
-        bbox.x1 = std::min(bbox.x1, shape_bbox.x1);
-        bbox.y1 = std::min(bbox.y1, shape_bbox.y1);
-        bbox.x2 = std::max(bbox.x2, shape_bbox.x2);
-        bbox.y2 = std::max(bbox.y2, shape_bbox.y2);
+// Whether p can hit one of the deferred shapes, before decoding them
+bool may_contain(const DeferredShapes& deferred, const Point& p) {
+    const BoundingBox& box = deferred.bounds;
+    double margin = deferred.hit_margin;
+    return p.x >= box.x1 - margin && p.x <= box.x2 + margin &&
+           p.y >= box.y1 - margin && p.y <= box.y2 + margin;
+}
+
+// Where an element can be hit
+template <typename Element>
+BoundingBox hit_box(const Element& element) {
+    const BoundingBox& box = element.bounding_box();
+    double margin = element.hit_margin();
+    return BoundingBox(box.x1 - margin, box.y1 - margin, box.x2 + margin, box.y2 + margin);
+}
+
+template <typename Element>
+std::shared_ptr<const SpatialIndex> build_index(const std::vector<std::shared_ptr<Element>>& elements) {
+    std::vector<SpatialIndex::Entry> entries;
+    entries.reserve(elements.size());
+    for (size_t i = 0; i < elements.size(); i++) {
+        entries.push_back({hit_box(*elements[i]), static_cast<uint32_t>(i)});
     }
-    
-    return bbox;
+    return std::make_shared<const SpatialIndex>(std::move(entries));
 }
 
-bool GraphNode::contains_point(const Point& p) const {
-    for (const auto& shape : shapes_) {
-        if (shape->contains_point(p)) {
-            return true;
+template <typename Element>
+std::shared_ptr<Element> topmost_at(const std::vector<std::shared_ptr<Element>>& elements,
+                                    const SpatialIndex& index, const Point& p, double flatness) {
+    std::vector<uint32_t> candidates;
+    index.query(p, candidates);
+    // Later elements are drawn on top; deferred ones decode only here
+    std::sort(candidates.begin(), candidates.end(), std::greater<uint32_t>());
+    for (uint32_t i : candidates) {
+        if (elements[i]->contains_point(p, flatness)) {
+            return elements[i];
         }
     }
-    return false;
+    return nullptr;
 }
 
-// GraphEdge implementation
-GraphEdge::GraphEdge(const std::string& source, const std::string& target, 
-                     const std::vector<std::shared_ptr<Shape>>& shapes)
-    : source_(source), target_(target), shapes_(shapes), highlighted_(false) {}
+template <typename Element>
+std::vector<std::shared_ptr<Element>> in_area(const std::vector<std::shared_ptr<Element>>& elements,
+                                              const SpatialIndex& index, const BoundingBox& area) {
+    std::vector<uint32_t> ids;
+    index.query(area, ids);
+    std::sort(ids.begin(), ids.end());
+    std::vector<std::shared_ptr<Element>> found;
+    found.reserve(ids.size());
+    for (uint32_t i : ids) {
+        found.push_back(elements[i]);
+    }
+    return found;
+}
 
-BoundingBox GraphEdge::bounding_box() const {
-    if (shapes_.empty()) {
-        return BoundingBox();
-    }
-    
-    BoundingBox bbox = shapes_[0]->bounding_box();
-    for (size_t i = 1; i < shapes_.size(); i++) {
-        BoundingBox shape_bbox = shapes_[i]->bounding_box();
-        bbox.x1 = std::min(bbox.x1, shape_bbox.x1);
-        bbox.y1 = std::min(bbox.y1, shape_bbox.y1);
-        bbox.x2 = std::max(bbox.x2, shape_bbox.x2);
-        bbox.y2 = std::max(bbox.y2, shape_bbox.y2);
+} // namespace
+
+// GraphNode implementation
+GraphNode::GraphNode(const std::string& id, std::shared_ptr<const DisplayList> list, OpRange ops)
+    : id_(id), list_(std::move(list)), ops_(ops), bounds_(list_->bounds(ops_)),
+      hit_margin_(list_->hit_margin(ops_)), highlighted_(false) {}
+
+GraphNode::GraphNode(const std::string& id, std::unique_ptr<DeferredShapes> deferred)
+    : id_(id), deferred_(std::move(deferred)), ops_(deferred_->ops()), bounds_(deferred_->bounds),
+      hit_margin_(deferred_->hit_margin), highlighted_(false) {}
+
+void GraphNode::update_bounding_box() {
+    bounds_ = deferred_ ? deferred_->bounds : list_->bounds(ops_);
+    hit_margin_ = deferred_ ? deferred_->hit_margin : list_->hit_margin(ops_);
+}
+
+bool GraphNode::contains_point(const Point& p, double flatness) const {
+    if (deferred_ && !may_contain(*deferred_, p)) {
+        return false;
     }
-    
-    return bbox;
+    return display_list().contains(ops_, p, flatness);
 }
 
-bool GraphEdge::contains_point(const Point& p) const {
-    for (const auto& shape : shapes_) {
-        if (shape->contains_point(p)) {
-            return true;
-        }
+// GraphEdge implementation
+GraphEdge::GraphEdge(const std::string& source, const std::string& target,
+                     std::shared_ptr<const DisplayList> list, OpRange ops)
+    : source_(source), target_(target), list_(std::move(list)), ops_(ops), bounds_(list_->bounds(ops_)),
+      hit_margin_(list_->hit_margin(ops_)), highlighted_(false) {}
+
+GraphEdge::GraphEdge(const std::string& source, const std::string& target,
+                     std::unique_ptr<DeferredShapes> deferred)
+    : source_(source), target_(target), deferred_(std::move(deferred)), ops_(deferred_->ops()),
+      bounds_(deferred_->bounds), hit_margin_(deferred_->hit_margin), highlighted_(false) {}
+
+void GraphEdge::update_bounding_box() {
+    bounds_ = deferred_ ? deferred_->bounds : list_->bounds(ops_);
+    hit_margin_ = deferred_ ? deferred_->hit_margin : list_->hit_margin(ops_);
+}
+
+bool GraphEdge::contains_point(const Point& p, double flatness) const {
+    if (deferred_ && !may_contain(*deferred_, p)) {
+        return false;
     }
-    return false;
+    return display_list().contains(ops_, p, flatness);
 }
 
 // GraphElement implementation
-GraphElement::GraphElement() {}
+GraphElement::GraphElement()
+    : pens_(std::make_shared<PenPool>()), prototypes_(std::make_shared<PrototypePool>()),
+      display_list_(std::make_shared<DisplayList>(pens_, prototypes_)),
+      shape_cache_(std::make_shared<ShapeCache>()),
+      has_bounds_(false), bounds_dirty_(false), has_deferred_shapes_(false) {}
 
 void GraphElement::add_node(std::shared_ptr<GraphNode> node) {
     nodes_.push_back(node);
     node_map_[node->id()] = node;
+    has_deferred_shapes_ = has_deferred_shapes_ || node->is_deferred();
+    include_bounds(node->bounding_box());
+    node_index_.reset();
 }
 
 void GraphElement::add_edge(std::shared_ptr<GraphEdge> edge) {
+    has_deferred_shapes_ = has_deferred_shapes_ || edge->is_deferred();
+    include_bounds(edge->bounding_box());
     edges_.push_back(edge);
+    edge_index_.reset();
 }
 
-void GraphElement::add_background_shape(std::shared_ptr<Shape> shape) {
-    background_shapes_.push_back(shape);
+void GraphElement::add_background(OpRange ops) {
+    if (ops.empty()) {
+        return;
+    }
+    include_bounds(display_list_->bounds(ops));
+    background_.push_back(ops);
 }
 
 BoundingBox GraphElement::bounding_box() const {
-    if (nodes_.empty() && edges_.empty() && background_shapes_.empty()) {
-        return BoundingBox();
-    }
-    
-    BoundingBox bbox;
-    bool first = true;
-    
-    // Include nodes
-    for (const auto& node : nodes_) {
-        BoundingBox node_bbox = node->bounding_box();
-        if (first) {
-            bbox = node_bbox;
-            first = false;
-        } else {
-            bbox.x1 = std::min(bbox.x1, node_bbox.x1);
-            bbox.y1 = std::min(bbox.y1, node_bbox.y1);
-            bbox.x2 = std::max(bbox.x2, node_bbox.x2);
-            bbox.y2 = std::max(bbox.y2, node_bbox.y2);
+    if (bounds_dirty_) {
+        has_bounds_ = false;
+        bounds_ = BoundingBox();
+        for (const auto& node : nodes_) {
+            include_bounds(node->bounding_box());
         }
-    }
-    
-    // Include edges
-    for (const auto& edge : edges_) {
-        BoundingBox edge_bbox = edge->bounding_box();
-        if (first) {
-            bbox = edge_bbox;
-            first = false;
-        } else {
-            bbox.x1 = std::min(bbox.x1, edge_bbox.x1);
-            bbox.y1 = std::min(bbox.y1, edge_bbox.y1);
-            bbox.x2 = std::max(bbox.x2, edge_bbox.x2);
-            bbox.y2 = std::max(bbox.y2, edge_bbox.y2);
+        for (const auto& edge : edges_) {
+            include_bounds(edge->bounding_box());
         }
-    }
-    
-    // Include background shapes
-    for (const auto& shape : background_shapes_) {
-        BoundingBox shape_bbox = shape->bounding_box();
-        if (first) {
-            bbox = shape_bbox;
-            first = false;
-        } else {
-            bbox.x1 = std::min(bbox.x1, shape_bbox.x1);
-            bbox.y1 = std::min(bbox.y1, shape_bbox.y1);
-            bbox.x2 = std::max(bbox.x2, shape_bbox.x2);
-            bbox.y2 = std::max(bbox.y2, shape_bbox.y2);
+        for (const auto& ops : background_) {
+            include_bounds(display_list_->bounds(ops));
         }
+        bounds_dirty_ = false;
     }
-    
-    return bbox;
+    return bounds_;
 }
 
-std::shared_ptr<GraphNode> GraphElement::find_node_at(const Point& p) const {
-    // Search in reverse order to find topmost node
-    for (auto it = nodes_.rbegin(); it != nodes_.rend(); ++it) {
-        if ((*it)->contains_point(p)) {
-            return *it;
-        }
+void GraphElement::include_bounds(const BoundingBox& box) const {
+    if (!has_bounds_) {
+        bounds_ = box;
+        has_bounds_ = true;
+        return;
     }
-    return nullptr;
+    bounds_.x1 = std::min(bounds_.x1, box.x1);
+    bounds_.y1 = std::min(bounds_.y1, box.y1);
+    bounds_.x2 = std::max(bounds_.x2, box.x2);
+    bounds_.y2 = std::max(bounds_.y2, box.y2);
 }
 
-std::shared_ptr<GraphEdge> GraphElement::find_edge_at(const Point& p) const {
-    // Search in reverse order to find topmost edge
-    for (auto it = edges_.rbegin(); it != edges_.rend(); ++it) {
-        if ((*it)->contains_point(p)) {
-            return *it;
-        }
+void GraphElement::invalidate_bounding_box() {
+    bounds_dirty_ = true;
+    node_index_.reset();
+    edge_index_.reset();
+}
+
+const SpatialIndex& GraphElement::node_index() const {
+    if (!node_index_) {
+        node_index_ = build_index(nodes_);
     }
-    return nullptr;
+    return *node_index_;
+}
+
+const SpatialIndex& GraphElement::edge_index() const {
+    if (!edge_index_) {
+        edge_index_ = build_index(edges_);
+    }
+    return *edge_index_;
+}
+
+std::shared_ptr<GraphNode> GraphElement::find_node_at(const Point& p, double flatness) const {
+    auto node = topmost_at(nodes_, node_index(), p, flatness);
+    // Counts the curves the hit tests flattened against the shape budget
+    shape_cache_->update();
+    return node;
+}
+
+std::shared_ptr<GraphEdge> GraphElement::find_edge_at(const Point& p, double flatness) const {
+    auto edge = topmost_at(edges_, edge_index(), p, flatness);
+    shape_cache_->update();
+    return edge;
+}
+
+std::vector<std::shared_ptr<GraphNode>> GraphElement::find_nodes_in(const BoundingBox& area) const {
+    return in_area(nodes_, node_index(), area);
+}
+
+std::vector<std::shared_ptr<GraphEdge>> GraphElement::find_edges_in(const BoundingBox& area) const {
+    return in_area(edges_, edge_index(), area);
 }
 
 void GraphElement::clear_highlights() {
@@ -0,0 +1,84 @@
+#include "xdot_cpp/xdot/pen_pool.h"
+#include <functional>
+#include <mutex>
+
+namespace xdot_cpp {
+namespace xdot {
+
+namespace {
+
+void combine(size_t& seed, size_t value) {
+    seed ^= value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+}
+
+void combine(size_t& seed, const Color& color) {
+    std::hash<double> hash;
+    combine(seed, hash(color.r));
+    combine(seed, hash(color.g));
+    combine(seed, hash(color.b));
+    combine(seed, hash(color.a));
+}
+
+size_t hash_pen(const Pen& pen) {
+    size_t seed = 0;
+    combine(seed, pen.color);
+    combine(seed, pen.fill_color);
+    combine(seed, std::hash<double>()(pen.line_width));
+    combine(seed, static_cast<size_t>(pen.line_style));
+    for (double dash : pen.dash_pattern) {
+        combine(seed, std::hash<double>()(dash));
+    }
+    combine(seed, std::hash<std::string>()(pen.font_family));
+    combine(seed, std::hash<double>()(pen.font_size));
+    return seed;
+}
+
+bool same_color(const Color& a, const Color& b) {
+    return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
+
+bool same_pen(const Pen& a, const Pen& b) {
+    return same_color(a.color, b.color) && same_color(a.fill_color, b.fill_color) &&
+           a.line_width == b.line_width && a.line_style == b.line_style &&
+           a.dash_pattern == b.dash_pattern && a.font_family == b.font_family &&
+           a.font_size == b.font_size;
+}
+
+} // namespace
+
+PenPool::PenPool() {
+    default_pen_ = intern(Pen());
+}
+
+const Pen* PenPool::intern(const Pen& pen) {
+    size_t hash = hash_pen(pen);
+    auto find = [&]() -> const Pen* {
+        auto range = index_.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (same_pen(*it->second, pen)) {
+                return it->second;
+            }
+        }
+        return nullptr;
+    };
+    
+    // Almost every call finds an existing pen
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        if (const Pen* existing = find()) {
+            return existing;
+        }
+    }
+    
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    if (const Pen* existing = find()) {
+        return existing;
+    }
+    
+    pens_.push_back(pen);
+    index_.emplace(hash, &pens_.back());
+    return &pens_.back();
+}
+
+} // namespace xdot
+} // namespace xdot_cpp
@@ -0,0 +1,96 @@
+#include "xdot_cpp/xdot/prototype_pool.h"
+#include <cmath>
+#include <functional>
+#include <mutex>
+
+namespace xdot_cpp {
+namespace xdot {
+
+namespace {
+
+// Points closer than this do not define a direction
+constexpr double MIN_DIRECTION_LENGTH = 1e-9;
+
+double snap(double value) {
+    return std::round(value / PrototypePool::GRID) * PrototypePool::GRID;
+}
+
+size_t hash_points(const std::vector<Point>& points) {
+    size_t seed = points.size();
+    std::hash<Coord> hash;
+    for (const auto& point : points) {
+        seed ^= hash(point.x) + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+        seed ^= hash(point.y) + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+    }
+    return seed;
+}
+
+bool same_points(const std::vector<Point>& a, const std::vector<Point>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].x != b[i].x || a[i].y != b[i].y) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+PrototypeIndex PrototypePool::intern(const Point* points, size_t count, Placement& placement) {
+    // Canonical form: the first point at the origin and the first distinct
+    // one after it on the positive x axis
+    placement = Placement();
+    if (count > 0) {
+        placement.offset = points[0];
+        for (size_t i = 1; i < count; i++) {
+            double dx = points[i].x - points[0].x;
+            double dy = points[i].y - points[0].y;
+            double length = std::hypot(dx, dy);
+            if (length > MIN_DIRECTION_LENGTH) {
+                placement.cos = dx / length;
+                placement.sin = dy / length;
+                break;
+            }
+        }
+    }
+
+    std::vector<Point> canonical;
+    canonical.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        Point local = placement.unapply(points[i]);
+        canonical.emplace_back(snap(local.x), snap(local.y));
+    }
+
+    size_t hash = hash_points(canonical);
+    auto find = [&]() -> PrototypeIndex {
+        auto range = index_.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (same_points(prototypes_[it->second], canonical)) {
+                return it->second;
+            }
+        }
+        return static_cast<PrototypeIndex>(-1);
+    };
+
+    // Repeated outlines are the common case
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        PrototypeIndex index = find();
+        if (index != static_cast<PrototypeIndex>(-1)) {
+            return index;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    PrototypeIndex existing = find();
+    if (existing != static_cast<PrototypeIndex>(-1)) {
+        return existing;
+    }
+
+    PrototypeIndex index = static_cast<PrototypeIndex>(prototypes_.size());
+    prototypes_.push_back(std::move(canonical));
+    index_.emplace(hash, index);
+    return index;
+}
+
+} // namespace xdot
+} // namespace xdot_cpp
@@ -0,0 +1,137 @@
+#include "xdot_cpp/xdot/shape_cache.h"
+#include "xdot_cpp/xdot/xdot_parser.h"
+
+namespace xdot_cpp {
+namespace xdot {
+
+// DeferredShapes implementation
+DeferredShapes::~DeferredShapes() {
+    if (cache && is_decoded()) {
+        cache->remove(*this);
+    }
+}
+
+const DisplayList& DeferredShapes::shapes() {
+    if (cache) {
+        return cache->shapes(*this);
+    }
+    if (!decoded_) {
+        decoded_ = decode();
+    }
+    return *decoded_;
+}
+
+std::unique_ptr<DisplayList> DeferredShapes::decode() const {
+    auto list = std::make_unique<DisplayList>(pens, prototypes);
+    for (std::string_view draw : draw_attributes) {
+        if (!draw.empty()) {
+            XDotAttrParser(draw).parse(*list);
+        }
+    }
+    list->shrink_to_fit();
+    return list;
+}
+
+// ShapeCache implementation
+void ShapeCache::set_budget(size_t budget) {
+    budget_ = budget;
+    trim(nullptr);
+}
+
+void ShapeCache::reset_counters() {
+    stats_.hits = 0;
+    stats_.misses = 0;
+    stats_.evictions = 0;
+}
+
+const DisplayList& ShapeCache::shapes(DeferredShapes& deferred) {
+    // Only the list handed out last can have grown since it was measured
+    if (newest_) {
+        measure(*newest_);
+    }
+    
+    if (deferred.is_decoded()) {
+        stats_.hits++;
+        if (newest_ != &deferred) {
+            unlink(deferred);
+            link(deferred);
+        }
+        trim(&deferred);
+        return *deferred.decoded_;
+    }
+    
+    stats_.misses++;
+    deferred.decoded_ = deferred.decode();
+    deferred.bytes_ = deferred.decoded_->memory_usage();
+    stats_.bytes += deferred.bytes_;
+    stats_.elements++;
+    link(deferred);
+    trim(&deferred);
+    return *deferred.decoded_;
+}
+
+void ShapeCache::update() {
+    if (newest_) {
+        measure(*newest_);
+        trim(nullptr);
+    }
+}
+
+void ShapeCache::remove(DeferredShapes& deferred) {
+    unlink(deferred);
+    stats_.bytes -= deferred.bytes_;
+    stats_.elements--;
+    deferred.bytes_ = 0;
+    deferred.decoded_.reset();
+}
+
+void ShapeCache::link(DeferredShapes& deferred) {
+    deferred.newer_ = nullptr;
+    deferred.older_ = newest_;
+    if (newest_) {
+        newest_->newer_ = &deferred;
+    } else {
+        oldest_ = &deferred;
+    }
+    newest_ = &deferred;
+}
+
+void ShapeCache::unlink(DeferredShapes& deferred) {
+    if (deferred.newer_) {
+        deferred.newer_->older_ = deferred.older_;
+    } else {
+        newest_ = deferred.older_;
+    }
+    if (deferred.older_) {
+        deferred.older_->newer_ = deferred.newer_;
+    } else {
+        oldest_ = deferred.newer_;
+    }
+    deferred.newer_ = nullptr;
+    deferred.older_ = nullptr;
+}
+
+void ShapeCache::evict(DeferredShapes& deferred) {
+    remove(deferred);
+    stats_.evictions++;
+}
+
+void ShapeCache::measure(DeferredShapes& deferred) {
+    size_t bytes = deferred.decoded_->memory_usage();
+    stats_.bytes = stats_.bytes - deferred.bytes_ + bytes;
+    deferred.bytes_ = bytes;
+}
+
+void ShapeCache::trim(const DeferredShapes* keep) {
+    if (budget_ == 0) {
+        return;
+    }
+    // The element just used stays even if it alone is over budget; the
+    // caller holds a reference to its shapes
+    while (stats_.bytes > budget_ && oldest_ && oldest_ != keep) {
+        evict(*oldest_);
+    }
+}
+
+} // namespace xdot
+} // namespace xdot_cpp
@@ -0,0 +1,151 @@
+#include "xdot_cpp/xdot/spatial_index.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace xdot_cpp {
+namespace xdot {
+
+namespace {
+
+double center_x(const BoundingBox& box) { return box.x1 + box.x2; }
+double center_y(const BoundingBox& box) { return box.y1 + box.y2; }
+
+// Orders items so that consecutive runs of NODE_CAPACITY are spatially close
+template <typename Item>
+void sort_tile(std::vector<Item>& items) {
+    size_t capacity = SpatialIndex::NODE_CAPACITY;
+    size_t groups = (items.size() + capacity - 1) / capacity;
+    size_t slices = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(groups))));
+    size_t slice_size = std::max<size_t>(slices * capacity, 1);
+
+    std::sort(items.begin(), items.end(), [](const Item& a, const Item& b) {
+        return center_x(a.box) < center_x(b.box);
+    });
+    for (size_t first = 0; first < items.size(); first += slice_size) {
+        auto end = items.begin() + std::min(first + slice_size, items.size());
+        std::sort(items.begin() + first, end, [](const Item& a, const Item& b) {
+            return center_y(a.box) < center_y(b.box);
+        });
+    }
+}
+
+// A node while its level is being packed
+struct PackedNode {
+    BoundingBox box;
+    uint32_t first;
+    uint8_t count;
+};
+
+inline unsigned count_trailing_zeros(uint32_t mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+} // namespace
+
+void SpatialIndex::Boxes::push_back(const BoundingBox& box) {
+    x1.push_back(box.x1);
+    y1.push_back(box.y1);
+    x2.push_back(box.x2);
+    y2.push_back(box.y2);
+}
+
+SpatialIndex::SpatialIndex(std::vector<Entry> entries) {
+    if (entries.empty()) {
+        return;
+    }
+
+    sort_tile(entries);
+    ids_.reserve(entries.size());
+    for (const auto& entry : entries) {
+        entry_boxes_.push_back(entry.box);
+        ids_.push_back(entry.id);
+    }
+
+    // One node per run of NODE_CAPACITY boxes
+    auto pack = [](const Boxes& boxes, size_t size) {
+        std::vector<PackedNode> nodes;
+        nodes.reserve((size + NODE_CAPACITY - 1) / NODE_CAPACITY);
+        for (size_t first = 0; first < size; first += NODE_CAPACITY) {
+            size_t count = std::min(NODE_CAPACITY, size - first);
+            nodes.push_back({geometry::union_bounds(boxes.arrays(), first, count),
+                             static_cast<uint32_t>(first), static_cast<uint8_t>(count)});
+        }
+        return nodes;
+    };
+    auto add_level = [this](const std::vector<PackedNode>& nodes) {
+        Level level;
+        for (const auto& node : nodes) {
+            level.boxes.push_back(node.box);
+            level.first.push_back(node.first);
+            level.count.push_back(node.count);
+        }
+        levels_.push_back(std::move(level));
+    };
+
+    std::vector<PackedNode> nodes = pack(entry_boxes_, ids_.size());
+    while (nodes.size() > NODE_CAPACITY) {
+        // Nodes are reordered before their parents point into them
+        sort_tile(nodes);
+        add_level(nodes);
+        nodes = pack(levels_.back().boxes, nodes.size());
+    }
+    add_level(nodes);
+}
+
+template <typename Mask>
+void SpatialIndex::search(const Mask& mask, std::vector<uint32_t>& ids) const {
+    if (levels_.empty()) {
+        return;
+    }
+
+    // (level, node) pairs still to visit
+    std::vector<std::pair<size_t, uint32_t>> stack;
+    size_t top = levels_.size() - 1;
+    uint32_t roots = mask(levels_[top].boxes, 0, levels_[top].first.size());
+    for (; roots; roots &= roots - 1) {
+        stack.emplace_back(top, count_trailing_zeros(roots));
+    }
+
+    while (!stack.empty()) {
+        auto [level, index] = stack.back();
+        stack.pop_back();
+        uint32_t first = levels_[level].first[index];
+        uint32_t count = levels_[level].count[index];
+
+        if (level == 0) {
+            for (uint32_t hits = mask(entry_boxes_, first, count); hits; hits &= hits - 1) {
+                ids.push_back(ids_[first + count_trailing_zeros(hits)]);
+            }
+        } else {
+            for (uint32_t hits = mask(levels_[level - 1].boxes, first, count); hits; hits &= hits - 1) {
+                stack.emplace_back(level - 1, first + count_trailing_zeros(hits));
+            }
+        }
+    }
+}
+
+void SpatialIndex::query(const Point& p, std::vector<uint32_t>& ids) const {
+    search([&p](const Boxes& boxes, size_t first, size_t count) {
+        return geometry::contains_mask(boxes.arrays(), first, count, p);
+    }, ids);
+}
+
+void SpatialIndex::query(const BoundingBox& area, std::vector<uint32_t>& ids) const {
+    search([&area](const Boxes& boxes, size_t first, size_t count) {
+        return geometry::intersects_mask(boxes.arrays(), first, count, area);
+    }, ids);
+}
+
+} // namespace xdot
+} // namespace xdot_cpp
@@ -1,67 +1,145 @@
 #include "xdot_cpp/xdot/xdot_parser.h"
 #include "xdot_cpp/xdot/color.h"
 #include "xdot_cpp/xdot/graph.h"
-#include <sstream>
+#include "xdot_cpp/xdot/prototype_pool.h"
+#include "xdot_cpp/dot/scanner.h"
+#include <array>
+#include <atomic>
 #include <cctype>
+#include <charconv>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <locale>
+#include <sstream>
+#include <thread>
 
 namespace xdot_cpp {
 namespace xdot {
 
-// XDotAttrParser implementation
-XDotAttrParser::XDotAttrParser(const std::string& xdot_data, bool broken_backslashes)
-    : data_(xdot_data), pos_(0) {
-    // Handle broken backslashes if needed
-    if (broken_backslashes) {
-        // Replace double backslashes with single backslashes
-        std::string fixed_data;
-        for (size_t i = 0; i < data_.length(); i++) {
-            if (data_[i] == '\\' && i + 1 < data_.length() && data_[i + 1] == '\\') {
-                fixed_data += '\\';
-                i++; // Skip the second backslash
-            } else {
-                fixed_data += data_[i];
-            }
+namespace {
+
+// Parses a decimal floating point number ("-1.5", ".5", "2e-3") at first
+// without consulting the locale, and with from_chars without allocating.
+// Returns the end of the number, or first if there is none.
+const char* parse_double(const char* first, const char* last, double& value) {
+#if defined(__cpp_lib_to_chars)
+    auto result = std::from_chars(first, last, value, std::chars_format::general);
+    if (result.ec == std::errc::invalid_argument) {
+        return first;
+    }
+    // Out of range values still consume the digits; keep the old 0 result
+    if (result.ec != std::errc()) {
+        value = 0.0;
+    }
+    return result.ptr;
+#else
+    // Standard libraries without floating point from_chars. strtod would
+    // follow the decimal point of the global locale, so the extent of the
+    // number is found here and a stream in the classic locale converts it.
+    const char* p = first;
+    if (p != last && *p == '-') {
+        p++;
+    }
+    size_t digits = 0;
+    for (; p != last && std::isdigit(static_cast<unsigned char>(*p)); p++) digits++;
+    if (p != last && *p == '.') {
+        p++;
+        for (; p != last && std::isdigit(static_cast<unsigned char>(*p)); p++) digits++;
+    }
+    if (digits == 0) {
+        return first;
+    }
+    if (p != last && (*p == 'e' || *p == 'E')) {
+        const char* exponent = p + 1;
+        if (exponent != last && (*exponent == '+' || *exponent == '-')) {
+            exponent++;
+        }
+        const char* exponent_digits = exponent;
+        while (exponent != last && std::isdigit(static_cast<unsigned char>(*exponent))) exponent++;
+        if (exponent != exponent_digits) {
+            p = exponent;
         }
-        data_ = fixed_data;
     }
+    std::istringstream stream(std::string(first, p));
+    stream.imbue(std::locale::classic());
+    // Out of range values still consume the digits; keep the old 0 result
+    if (!(stream >> value)) {
+        value = 0.0;
+    }
+    return p;
+#endif
 }
 
-std::vector<std::shared_ptr<Shape>> XDotAttrParser::parse() {
-    shapes_.clear();
+} // namespace
+
+// XDotAttrParser implementation
+XDotAttrParser::XDotAttrParser(std::string_view xdot_data, bool broken_backslashes)
+    : data_(xdot_data), pos_(0), broken_backslashes_(broken_backslashes), list_(nullptr),
+      current_entry_(nullptr), pen_changed_(true), bounds_only_(false), shape_count_(0),
+      hit_margin_(0.0) {}
+
+const XDotAttrParser::Handler* XDotAttrParser::opcode_table() {
+    static const auto table = [] {
+        // Bytes without a handler are skipped
+        std::array<Handler, 256> handlers{};
+        handlers['E'] = &XDotAttrParser::handle_ellipse;
+        handlers['P'] = &XDotAttrParser::handle_polygon;
+        handlers['L'] = &XDotAttrParser::handle_polyline;
+        handlers['B'] = &XDotAttrParser::handle_bezier;
+        handlers['T'] = &XDotAttrParser::handle_text;
+        handlers['I'] = &XDotAttrParser::handle_image;
+        handlers['S'] = &XDotAttrParser::handle_style;
+        handlers['c'] = &XDotAttrParser::handle_color;
+        handlers['C'] = &XDotAttrParser::handle_fill_color;
+        handlers['F'] = &XDotAttrParser::handle_font;
+        return handlers;
+    }();
+    return table.data();
+}
+
+OpRange XDotAttrParser::parse(DisplayList& list) {
+    OpRange ops;
+    ops.first = static_cast<uint32_t>(list.size());
+    list_ = &list;
+    bounds_only_ = false;
+    run();
+    list_ = nullptr;
+    ops.end = static_cast<uint32_t>(list.size());
+    return ops;
+}
+
+size_t XDotAttrParser::scan_bounds(BoundingBox& bounds, double& hit_margin) {
+    bounds_only_ = true;
+    shape_count_ = 0;
+    bounds_ = BoundingBox();
+    hit_margin_ = 0.0;
+    run();
+    bounds_only_ = false;
+    
+    bounds = bounds_;
+    hit_margin = hit_margin_;
+    return shape_count_;
+}
+
+void XDotAttrParser::run() {
+    const Handler* handlers = opcode_table();
     pos_ = 0;
+    current_pen_ = Pen();
+    pen_changed_ = true;
     
-    while (has_more()) {
+    while (true) {
         skip_whitespace();
         if (!has_more()) break;
         
-        std::string code = read_code();
-        
-        if (code == "E") {
-            handle_ellipse();
-        } else if (code == "P") {
-            handle_polygon();
-        } else if (code == "L") {
-            handle_polyline();
-        } else if (code == "B") {
-            handle_bezier();
-        } else if (code == "T") {
-            handle_text();
-        } else if (code == "I") {
-            handle_image();
-        } else if (code == "S") {
-            handle_style();
-        } else if (code == "c") {
-            handle_color();
-        } else if (code == "C") {
-            handle_fill_color();
-        } else if (code == "F") {
-            handle_font();
-        }
-        // Ignore unknown codes
-    }
-    
-    return shapes_;
+        // Operations are a single byte. Unknown ones are skipped a byte at
+        // a time, operands included, so parsing always makes progress.
+        Handler handler = handlers[static_cast<unsigned char>(data_[pos_++])];
+        if (handler) {
+            (this->*handler)();
+        }
+    }
 }
 
 bool XDotAttrParser::has_more() const {
@@ -78,61 +156,46 @@ void XDotAttrParser::advance() {
 }
 
 void XDotAttrParser::skip_whitespace() {
-    while (has_more() && std::isspace(current_char())) {
-        advance();
+    while (has_more() && dot::char_classes.is(data_[pos_], dot::CC_SPACE)) {
+        pos_++;
     }
 }
 
-std::string XDotAttrParser::read_code() {
-    skip_whitespace();
-    std::string code;
-    while (has_more() && std::isalpha(current_char())) {
-        code += current_char();
-        advance();
-    }
-    return code;
-}
-
 int XDotAttrParser::read_int() {
     skip_whitespace();
-    std::string num_str;
-    bool negative = false;
+    const char* first = data_.data() + pos_;
+    const char* last = data_.data() + data_.length();
     
-    if (current_char() == '-') {
-        negative = true;
-        advance();
+    // from_chars does not take a leading '+'
+    if (first < last && *first == '+') {
+        first++;
     }
     
-    while (has_more() && std::isdigit(current_char())) {
-        num_str += current_char();
-        advance();
+    int value = 0;
+    auto result = std::from_chars(first, last, value);
+    if (result.ec == std::errc::invalid_argument) {
+        return 0;
     }
-    
-    if (num_str.empty()) return 0;
-    
-    int result = std::stoi(num_str);
-    return negative ? -result : result;
+    pos_ = static_cast<size_t>(result.ptr - data_.data());
+    return result.ec == std::errc() ? value : 0;
 }
 
 double XDotAttrParser::read_float() {
     skip_whitespace();
-    std::string num_str;
-    bool negative = false;
+    const char* first = data_.data() + pos_;
+    const char* last = data_.data() + data_.length();
     
-    if (current_char() == '-') {
-        negative = true;
-        advance();
+    if (first < last && *first == '+') {
+        first++;
     }
     
-    while (has_more() && (std::isdigit(current_char()) || current_char() == '.')) {
-        num_str += current_char();
-        advance();
+    double value = 0.0;
+    const char* end = parse_double(first, last, value);
+    if (end == first) {
+        return 0.0;
     }
-    
-    if (num_str.empty()) return 0.0;
-    
-    double result = std::stod(num_str);
-    return negative ? -result : result;
+    pos_ = static_cast<size_t>(end - data_.data());
+    return value;
 }
 
 Point XDotAttrParser::read_point() {
@@ -141,7 +204,7 @@ Point XDotAttrParser::read_point() {
     return transform(x, y);
 }
 
-std::string XDotAttrParser::read_text() {
+std::string_view XDotAttrParser::read_text() {
     skip_whitespace();
     int length = read_int();
     skip_whitespace();
@@ -151,35 +214,77 @@ std::string XDotAttrParser::read_text() {
         skip_whitespace();
     }
     
-    std::string text;
-    for (int i = 0; i < length && has_more(); i++) {
-        text += current_char();
-        advance();
+    size_t count = length > 0 ? static_cast<size_t>(length) : 0;
+    size_t begin = pos_;
+    
+    if (broken_backslashes_) {
+        // length counts the text with doubled backslashes collapsed; only
+        // copy when there actually is one
+        size_t produced = 0;
+        bool fixed = false;
+        while (produced < count && has_more()) {
+            if (data_[pos_] == '\\' && pos_ + 1 < data_.length() && data_[pos_ + 1] == '\\') {
+                if (!fixed) {
+                    text_.assign(data_.data() + begin, pos_ - begin);
+                    fixed = true;
+                }
+                text_ += '\\';
+                pos_ += 2;
+            } else {
+                if (fixed) text_ += data_[pos_];
+                pos_++;
+            }
+            produced++;
+        }
+        if (fixed) {
+            return text_;
+        }
+        return data_.substr(begin, pos_ - begin);
     }
     
-    return text;
+    count = std::min(count, data_.length() - pos_);
+    pos_ += count;
+    return data_.substr(begin, count);
 }
 
-std::vector<Point> XDotAttrParser::read_polygon() {
+void XDotAttrParser::read_polygon(std::vector<Point>& points) {
     int num_points = read_int();
-    std::vector<Point> points;
+    points.clear();
+    points.reserve(num_points > 0 ? static_cast<size_t>(num_points) : 0);
     
     for (int i = 0; i < num_points; i++) {
         points.push_back(read_point());
     }
-    
-    return points;
 }
 
 Color XDotAttrParser::read_color() {
-    std::string color_spec = read_text();
-    return ColorLookup::lookup_color(color_spec);
+    return ColorLookup::lookup_color(read_text());
 }
 
 Point XDotAttrParser::transform(double x, double y) const {
-    // For now, just return the coordinates as-is
-    // In a full implementation, this would apply coordinate transformations
-    return Point(x, y);
+    // Coordinates are parsed as double and rounded to Coord once, here
+    return Point(static_cast<Coord>(x), static_cast<Coord>(y));
+}
+
+const Pen* XDotAttrParser::pen_entry() {
+    if (pen_changed_) {
+        current_entry_ = list_->pens()->intern(current_pen_);
+        pen_changed_ = false;
+    }
+    return current_entry_;
+}
+
+void XDotAttrParser::add_bounds(const BoundingBox& box, double hit_margin) {
+    if (shape_count_ == 0) {
+        bounds_ = box;
+    } else {
+        bounds_.x1 = std::min(bounds_.x1, box.x1);
+        bounds_.y1 = std::min(bounds_.y1, box.y1);
+        bounds_.x2 = std::max(bounds_.x2, box.x2);
+        bounds_.y2 = std::max(bounds_.y2, box.y2);
+    }
+    hit_margin_ = std::max(hit_margin_, hit_margin);
+    shape_count_++;
 }
 
 void XDotAttrParser::handle_ellipse() {
@@ -192,12 +297,18 @@ void XDotAttrParser::handle_ellipse() {
     width *= buffer_factor;
     height *= buffer_factor;
     
-    auto ellipse = std::make_shared<EllipseShape>(center, width, height, current_pen_);
-    shapes_.push_back(ellipse);
+    if (bounds_only_) {
+        add_bounds(BoundingBox(center.x - width / 2.0, center.y - height / 2.0,
+                               center.x + width / 2.0, center.y + height / 2.0));
+        return;
+    }
+    
+    list_->add_ellipse(center, static_cast<Coord>(width), static_cast<Coord>(height), pen_entry());
 }
 
 void XDotAttrParser::handle_polygon() {
-    std::vector<Point> points = read_polygon();
+    std::vector<Point>& points = scratch_points_;
+    read_polygon(points);
     
     // Add buffer to polygon by expanding it outward from its center
     if (!points.empty()) {
@@ -220,177 +331,652 @@ void XDotAttrParser::handle_polygon() {
         }
     }
     
-    auto polygon = std::make_shared<PolygonShape>(points, current_pen_);
-    shapes_.push_back(polygon);
+    if (bounds_only_) {
+        // Placed prototypes may stray from the input by the snapping grid
+        add_bounds(points_bounding_box(points.data(), points.size()), PrototypePool::GRID);
+        return;
+    }
+    
+    list_->add_polygon(points.data(), points.size(), pen_entry());
 }
 
 void XDotAttrParser::handle_polyline() {
-    std::vector<Point> points = read_polygon(); // Same format as polygon
+    read_polygon(scratch_points_); // Same format as polygon
+    if (bounds_only_) {
+        add_bounds(points_bounding_box(scratch_points_.data(), scratch_points_.size()),
+                   current_pen_.line_width + 2.0);
+        return;
+    }
     
-    auto polyline = std::make_shared<PolylineShape>(points, current_pen_);
-    shapes_.push_back(polyline);
+    list_->add_polyline(scratch_points_.data(), scratch_points_.size(), pen_entry());
 }
 
 void XDotAttrParser::handle_bezier() {
-    std::vector<Point> control_points = read_polygon(); // Same format as polygon
+    read_polygon(scratch_points_); // Same format as polygon
+    if (bounds_only_) {
+        add_bounds(points_bounding_box(scratch_points_.data(), scratch_points_.size()),
+                   current_pen_.line_width + 5.0);
+        return;
+    }
     
-    auto bezier = std::make_shared<BezierShape>(control_points, current_pen_);
-    shapes_.push_back(bezier);
+    list_->add_bezier(scratch_points_.data(), scratch_points_.size(), pen_entry());
 }
 
 void XDotAttrParser::handle_text() {
     Point position = read_point();
-    int alignment = read_int(); // Text alignment (ignored for now)
-    double width = read_float(); // Text width (ignored for now)
-    std::string text = read_text();
+    read_int(); // Text alignment (ignored for now)
+    read_float(); // Text width (ignored for now)
+    std::string_view text = read_text();
     
-    auto text_shape = std::make_shared<TextShape>(position, text, current_pen_);
-    shapes_.push_back(text_shape);
+    if (bounds_only_) {
+        add_bounds(text_bounding_box(position, text.length(), current_pen_.font_size));
+        return;
+    }
+    
+    list_->add_text(position, text, pen_entry());
 }
 
 void XDotAttrParser::handle_image() {
     Point position = read_point();
     double width = read_float();
     double height = read_float();
-    std::string image_path = read_text();
+    std::string_view image_path = read_text();
+    
+    if (bounds_only_) {
+        add_bounds(BoundingBox(position.x, position.y, position.x + width, position.y + height));
+        return;
+    }
     
-    auto image = std::make_shared<ImageShape>(position, width, height, image_path);
-    shapes_.push_back(image);
+    list_->add_image(position, static_cast<Coord>(width), static_cast<Coord>(height), image_path);
 }
 
 void XDotAttrParser::handle_style() {
-    std::string style = read_text();
+    if (bounds_only_) {
+        read_text(); // Does not affect geometry
+        return;
+    }
+    std::string_view style = read_text();
     
     // Parse style attributes (simplified)
-    if (style.find("solid") != std::string::npos) {
+    if (style.find("solid") != std::string_view::npos) {
         current_pen_.set_line_style(LineStyle::SOLID);
-    } else if (style.find("dashed") != std::string::npos) {
+    } else if (style.find("dashed") != std::string_view::npos) {
         current_pen_.set_line_style(LineStyle::DASHED);
-    } else if (style.find("dotted") != std::string::npos) {
+    } else if (style.find("dotted") != std::string_view::npos) {
         current_pen_.set_line_style(LineStyle::DOTTED);
     }
+    pen_changed_ = true;
 }
 
 void XDotAttrParser::handle_color() {
+    if (bounds_only_) {
+        read_text(); // Does not affect geometry
+        return;
+    }
     Color color = read_color();
     current_pen_.set_color(color);
+    pen_changed_ = true;
 }
 
 void XDotAttrParser::handle_fill_color() {
+    if (bounds_only_) {
+        read_text(); // Does not affect geometry
+        return;
+    }
     Color fill_color = read_color();
     current_pen_.set_fill_color(fill_color);
+    pen_changed_ = true;
 }
 
 void XDotAttrParser::handle_font() {
     double font_size = read_float();
-    std::string font_name = read_text();
-    current_pen_.set_font(font_name, font_size);
+    std::string_view font_name = read_text();
+    if (font_size != current_pen_.font_size || font_name != current_pen_.font_family) {
+        current_pen_.set_font(std::string(font_name), font_size);
+        pen_changed_ = true;
+    }
+}
+
+namespace {
+
+// Appends the shapes of a node or edge to list, in drawing order
+OpRange element_ops(const DrawAttributes& draw_attributes, DisplayList& list) {
+    OpRange ops;
+    ops.first = static_cast<uint32_t>(list.size());
+    for (size_t slot = 0; slot < DrawAttributes::SHAPE_SLOT_COUNT; slot++) {
+        std::string_view draw = draw_attributes.values[slot];
+        if (!draw.empty()) {
+            XDotAttrParser(draw).parse(list);
+        }
+    }
+    ops.end = static_cast<uint32_t>(list.size());
+    return ops;
+}
+
+// Bounds of what the drawing attributes decode to, for decoding later;
+// nullptr if they draw nothing
+std::unique_ptr<DeferredShapes> defer_shapes(const DrawAttributes& draw_attributes,
+                                             const GraphElement& graph,
+                                             const std::shared_ptr<const void>& source) {
+    auto deferred = std::make_unique<DeferredShapes>();
+    size_t shape_count = 0;
+    
+    for (size_t slot = 0; slot < DrawAttributes::SHAPE_SLOT_COUNT; slot++) {
+        std::string_view draw = draw_attributes.values[slot];
+        if (draw.empty()) {
+            continue;
+        }
+        BoundingBox bounds;
+        double hit_margin = 0.0;
+        size_t count = XDotAttrParser(draw).scan_bounds(bounds, hit_margin);
+        if (count == 0) {
+            continue;
+        }
+        if (shape_count == 0) {
+            deferred->bounds = bounds;
+        } else {
+            deferred->bounds.x1 = std::min(deferred->bounds.x1, bounds.x1);
+            deferred->bounds.y1 = std::min(deferred->bounds.y1, bounds.y1);
+            deferred->bounds.x2 = std::max(deferred->bounds.x2, bounds.x2);
+            deferred->bounds.y2 = std::max(deferred->bounds.y2, bounds.y2);
+        }
+        deferred->hit_margin = std::max(deferred->hit_margin, hit_margin);
+        shape_count += count;
+    }
+    
+    if (shape_count == 0) {
+        return nullptr;
+    }
+    std::copy_n(draw_attributes.values.begin(), DrawAttributes::SHAPE_SLOT_COUNT,
+                deferred->draw_attributes.begin());
+    deferred->op_count = static_cast<uint32_t>(shape_count);
+    deferred->pens = graph.pens();
+    deferred->prototypes = graph.prototypes();
+    deferred->source = source;
+    deferred->cache = graph.shape_cache();
+    return deferred;
+}
+
+// Shapes are decoded into list or, with a source, deferred and decoded
+// from views into it
+std::shared_ptr<GraphNode> make_node(std::string_view id, const DrawAttributes& draw,
+                                     const GraphElement& graph, const std::shared_ptr<DisplayList>& list,
+                                     const std::shared_ptr<const void>& source = nullptr) {
+    std::shared_ptr<GraphNode> graph_node;
+    if (source) {
+        auto deferred = defer_shapes(draw, graph, source);
+        if (!deferred) {
+            return nullptr;
+        }
+        graph_node = std::make_shared<GraphNode>(std::string(id), std::move(deferred));
+    } else {
+        OpRange ops = element_ops(draw, *list);
+        if (ops.empty()) {
+            return nullptr;
+        }
+        graph_node = std::make_shared<GraphNode>(std::string(id), list, ops);
+    }
+    
+    if (!draw[DrawAttributes::URL].empty()) {
+        graph_node->set_url(std::string(draw[DrawAttributes::URL]));
+    }
+    return graph_node;
+}
+
+std::shared_ptr<GraphEdge> make_edge(std::string_view source, std::string_view target,
+                                     const DrawAttributes& draw,
+                                     const GraphElement& graph, const std::shared_ptr<DisplayList>& list,
+                                     const std::shared_ptr<const void>& draw_source = nullptr) {
+    std::shared_ptr<GraphEdge> graph_edge;
+    if (draw_source) {
+        auto deferred = defer_shapes(draw, graph, draw_source);
+        if (!deferred) {
+            return nullptr;
+        }
+        graph_edge = std::make_shared<GraphEdge>(std::string(source), std::string(target),
+                                                 std::move(deferred));
+    } else {
+        OpRange ops = element_ops(draw, *list);
+        if (ops.empty()) {
+            return nullptr;
+        }
+        graph_edge = std::make_shared<GraphEdge>(std::string(source), std::string(target), list, ops);
+    }
+    
+    if (!draw[DrawAttributes::URL].empty()) {
+        graph_edge->set_url(std::string(draw[DrawAttributes::URL]));
+    }
+    return graph_edge;
 }
 
+// Background shapes of a graph or subgraph: _draw_, then _ldraw_
+void append_graph_shapes(const DrawAttributes& draw, DisplayList& list) {
+    for (DrawAttributes::Slot slot : {DrawAttributes::DRAW, DrawAttributes::LDRAW}) {
+        if (!draw[slot].empty()) {
+            XDotAttrParser(draw[slot]).parse(list);
+        }
+    }
+}
+
+// Clusters and other subgraphs, outer ones first
+void append_subgraph_shapes(const dot::Subgraph& subgraph, DisplayList& list) {
+    append_graph_shapes(DrawAttributes::of(subgraph.attributes), list);
+    for (const auto& child : subgraph.subgraphs) {
+        append_subgraph_shapes(*child, list);
+    }
+}
+
+// Elements a worker claims at a time
+constexpr size_t DECODE_BLOCK_SIZE = 512;
+
+} // namespace
+
 // XDotParser implementation
-XDotParser::XDotParser(std::shared_ptr<dot::Graph> graph) : graph_(graph) {}
+XDotParser::XDotParser(std::shared_ptr<dot::Graph> graph, size_t workers)
+    : graph_(graph), workers_(workers), lazy_(false) {}
 
 std::shared_ptr<GraphElement> XDotParser::parse() {
     auto graph_element = std::make_shared<GraphElement>();
+    const GraphElement& graph = *graph_element;
+    
+    // The graph's own drawing and label, then those of its clusters
+    DisplayList& background = *graph_element->display_list();
+    OpRange background_ops;
+    background_ops.first = static_cast<uint32_t>(background.size());
+    append_graph_shapes(DrawAttributes::of(graph_->attributes), background);
+    for (const auto& subgraph : graph_->subgraphs) {
+        append_subgraph_shapes(*subgraph, background);
+    }
+    background_ops.end = static_cast<uint32_t>(background.size());
+    graph_element->add_background(background_ops);
+    
+    // Nodes and edges are decoded into slots by document position, so the
+    // order of the scene does not depend on which thread decoded what
+    const size_t node_count = graph_->nodes.size();
+    const size_t total = node_count + graph_->edges.size();
+    std::vector<std::shared_ptr<GraphNode>> graph_nodes(node_count);
+    std::vector<std::shared_ptr<GraphEdge>> graph_edges(graph_->edges.size());
+    // Deferred shapes keep the graph, which owns the attribute values
+    std::shared_ptr<const void> source = lazy_ ? graph_ : nullptr;
     
-    // Parse graph background shapes from graph attributes
-    std::string graph_draw = get_attribute_value(graph_->attributes, "_draw_");
-    if (!graph_draw.empty()) {
-        auto bg_shapes = parse_xdot_attr(graph_draw);
-        for (auto& shape : bg_shapes) {
-            graph_element->add_background_shape(shape);
+    // The elements of a block share one display list
+    auto decode = [&](size_t begin, size_t end) {
+        std::shared_ptr<DisplayList> list;
+        if (!lazy_) {
+            list = std::make_shared<DisplayList>(graph.pens(), graph.prototypes());
+        }
+        for (size_t i = begin; i < end; i++) {
+            if (i < node_count) {
+                const auto& node = graph_->nodes[i];
+                graph_nodes[i] = make_node(node->id, DrawAttributes::of(node->attributes, node->defaults),
+                                           graph, list, source);
+            } else {
+                const auto& edge = graph_->edges[i - node_count];
+                graph_edges[i - node_count] = make_edge(graph_->nodes[edge->source]->id,
+                                                        graph_->nodes[edge->target]->id,
+                                                        DrawAttributes::of(edge->attributes, edge->defaults),
+                                                        graph, list, source);
+            }
         }
+        if (list) {
+            list->shrink_to_fit();
+        }
+    };
+    
+    size_t workers = workers_;
+    if (workers == 0) {
+        workers = std::max<size_t>(1, std::thread::hardware_concurrency());
     }
+    workers = std::min(workers, (total + DECODE_BLOCK_SIZE - 1) / DECODE_BLOCK_SIZE);
     
-    // Parse nodes
-    for (const auto& node : graph_->nodes) {
-        std::string node_draw = get_attribute_value(node->attributes, "_draw_");
-        std::string node_ldraw = get_attribute_value(node->attributes, "_ldraw_");
-        
-        std::vector<std::shared_ptr<Shape>> node_shapes;
-        
-        // Parse node drawing commands
-        if (!node_draw.empty()) {
-            auto shapes = parse_xdot_attr(node_draw);
-            node_shapes.insert(node_shapes.end(), shapes.begin(), shapes.end());
+    if (workers <= 1) {
+        for (size_t begin = 0; begin < total; begin += DECODE_BLOCK_SIZE) {
+            decode(begin, std::min(begin + DECODE_BLOCK_SIZE, total));
         }
+    } else {
+        // Blocks are handed out dynamically; edges with long splines cost
+        // far more than plain nodes
+        std::atomic<size_t> next_block{0};
+        auto work = [&]() {
+            size_t begin;
+            while ((begin = next_block.fetch_add(DECODE_BLOCK_SIZE)) < total) {
+                decode(begin, std::min(begin + DECODE_BLOCK_SIZE, total));
+            }
+        };
         
-        // Parse node label drawing commands
-        if (!node_ldraw.empty()) {
-            auto shapes = parse_xdot_attr(node_ldraw);
-            node_shapes.insert(node_shapes.end(), shapes.begin(), shapes.end());
+        std::vector<std::thread> threads;
+        threads.reserve(workers - 1);
+        for (size_t i = 1; i < workers; i++) {
+            threads.emplace_back(work);
         }
-        
-        if (!node_shapes.empty()) {
-            auto graph_node = std::make_shared<GraphNode>(node->id, node_shapes);
-            
-            // Set URL if present
-            std::string url = get_attribute_value(node->attributes, "URL");
-            if (!url.empty()) {
-                graph_node->set_url(url);
-            }
-            
-            graph_element->add_node(graph_node);
+        work();
+        for (auto& thread : threads) {
+            thread.join();
         }
     }
     
-    // Parse edges
-    for (const auto& edge : graph_->edges) {
-        std::string edge_draw = get_attribute_value(edge->attributes, "_draw_");
-        std::string edge_hdraw = get_attribute_value(edge->attributes, "_hdraw_");
-        std::string edge_ldraw = get_attribute_value(edge->attributes, "_ldraw_");
-        
-        std::vector<std::shared_ptr<Shape>> edge_shapes;
-        
-        // Parse edge drawing commands
-        if (!edge_draw.empty()) {
-            auto shapes = parse_xdot_attr(edge_draw);
-            edge_shapes.insert(edge_shapes.end(), shapes.begin(), shapes.end());
+    for (auto& graph_node : graph_nodes) {
+        if (graph_node) {
+            graph_element->add_node(std::move(graph_node));
         }
-        
-        // Parse edge head drawing commands
-        if (!edge_hdraw.empty()) {
-            auto shapes = parse_xdot_attr(edge_hdraw);
-            edge_shapes.insert(edge_shapes.end(), shapes.begin(), shapes.end());
+    }
+    for (auto& graph_edge : graph_edges) {
+        if (graph_edge) {
+            graph_element->add_edge(std::move(graph_edge));
+        }
+    }
+    
+    return graph_element;
+}
+
+// XDotSceneBuilder implementation
+XDotSceneBuilder::XDotSceneBuilder()
+    : graph_element_(std::make_shared<GraphElement>()), kind_(dot::TokenType::EOF_TOKEN),
+      is_defaults_(false) {
+    scopes_.emplace_back();
+}
+
+void XDotSceneBuilder::on_subgraph_begin(std::string_view /*id*/) {
+    scopes_.push_back(scopes_.back());
+}
+
+void XDotSceneBuilder::on_subgraph_end() {
+    scopes_.pop_back();
+}
+
+void XDotSceneBuilder::on_node(std::string_view id) {
+    begin_statement(dot::TokenType::NODE);
+    id_ = id;
+}
+
+void XDotSceneBuilder::on_edge(std::string_view source, std::string_view target) {
+    begin_statement(dot::TokenType::EDGE);
+    id_ = source;
+    target_ = target;
+}
+
+void XDotSceneBuilder::on_attributes(dot::TokenType kind) {
+    begin_statement(kind);
+    is_defaults_ = true;
+}
+
+void XDotSceneBuilder::on_attribute(std::string_view name, std::string_view value) {
+    // Views stay valid until the statement ends
+    DrawAttributes::Slot slot = DrawAttributes::slot_of(name);
+    if (slot != DrawAttributes::NO_SLOT) {
+        current_[slot] = value;
+    }
+}
+
+void XDotSceneBuilder::on_statement_end() {
+    if (kind_ == dot::TokenType::GRAPH) {
+        // Graph and cluster drawings make up the background
+        DisplayList& list = *graph_element_->display_list();
+        OpRange ops;
+        ops.first = static_cast<uint32_t>(list.size());
+        append_graph_shapes(current_, list);
+        ops.end = static_cast<uint32_t>(list.size());
+        graph_element_->add_background(ops);
+    } else if (is_defaults_) {
+        if (kind_ == dot::TokenType::NODE) {
+            store(current_, scopes_.back().node);
+        } else if (kind_ == dot::TokenType::EDGE) {
+            store(current_, scopes_.back().edge);
+        }
+    } else if (kind_ == dot::TokenType::NODE) {
+        add_node(id_, current_);
+    } else if (kind_ == dot::TokenType::EDGE) {
+        add_edge(id_, target_, current_);
+    }
+    kind_ = dot::TokenType::EOF_TOKEN;
+}
+
+void XDotSceneBuilder::add_node(std::string_view id, const DrawAttributes& draw) {
+    auto graph_node = make_node(id, draw, *graph_element_, graph_element_->display_list());
+    if (graph_node) {
+        graph_element_->add_node(graph_node);
+    }
+}
+
+void XDotSceneBuilder::add_edge(std::string_view source, std::string_view target, const DrawAttributes& draw) {
+    auto graph_edge = make_edge(source, target, draw, *graph_element_, graph_element_->display_list());
+    if (graph_edge) {
+        graph_element_->add_edge(graph_edge);
+    }
+}
+
+void XDotSceneBuilder::begin_statement(dot::TokenType kind) {
+    kind_ = kind;
+    is_defaults_ = false;
+    current_ = DrawAttributes();
+    if (kind == dot::TokenType::NODE) {
+        load(scopes_.back().node, current_);
+    } else if (kind == dot::TokenType::EDGE) {
+        load(scopes_.back().edge, current_);
+    }
+}
+
+void XDotSceneBuilder::load(const StoredAttributes& stored, DrawAttributes& draw) {
+    for (size_t slot = 0; slot < DrawAttributes::SLOT_COUNT; slot++) {
+        draw.values[slot] = stored[slot];
+    }
+}
+
+void XDotSceneBuilder::store(const DrawAttributes& draw, StoredAttributes& stored) {
+    // draw may refer to the strings being replaced
+    StoredAttributes copy;
+    for (size_t slot = 0; slot < DrawAttributes::SLOT_COUNT; slot++) {
+        copy[slot].assign(draw.values[slot]);
+    }
+    stored = std::move(copy);
+}
+
+// SceneLoader implementation
+
+// Node and edge statements of one stretch of input, and what they decode to
+struct SceneLoader::Batch {
+    struct Range {
+        uint32_t begin = 0;
+        uint32_t length = 0;
+    };
+    
+    struct Element {
+        bool is_edge;
+        Range id;        // edge source
+        Range target;
+        std::array<Range, DrawAttributes::SLOT_COUNT> values;
+    };
+    
+    size_t sequence = 0;
+    // Strings of the statements, referred to by the ranges
+    std::string text;
+    std::vector<Element> elements;
+    
+    // Shared by the decoded nodes and edges
+    std::shared_ptr<DisplayList> list;
+    std::vector<std::shared_ptr<GraphNode>> nodes;
+    std::vector<std::shared_ptr<GraphEdge>> edges;
+    
+    Range store(std::string_view value) {
+        Range range{static_cast<uint32_t>(text.size()), static_cast<uint32_t>(value.size())};
+        text.append(value);
+        return range;
+    }
+    
+    std::string_view view(Range range) const {
+        return std::string_view(text).substr(range.begin, range.length);
+    }
+};
+
+// Collects statements for the workers instead of decoding them
+class SceneLoader::Collector : public XDotSceneBuilder {
+public:
+    explicit Collector(SceneLoader& loader) : loader_(loader) {}
+    
+protected:
+    void add_node(std::string_view id, const DrawAttributes& draw) override {
+        loader_.collect(id, {}, false, draw);
+    }
+    
+    void add_edge(std::string_view source, std::string_view target, const DrawAttributes& draw) override {
+        loader_.collect(source, target, true, draw);
+    }
+    
+private:
+    SceneLoader& loader_;
+};
+
+SceneLoader::SceneLoader(size_t workers)
+    : collector_(std::make_unique<Collector>(*this)), graph_element_(collector_->graph_element()),
+      adapter_(*collector_), parser_(adapter_), next_sequence_(0), next_publish_(0),
+      stopping_(false) {
+    if (workers == 0) {
+        workers = std::max<size_t>(2, std::thread::hardware_concurrency()) - 1;
+    }
+    for (size_t i = 0; i < workers; i++) {
+        workers_.emplace_back(&SceneLoader::work, this);
+    }
+}
+
+SceneLoader::~SceneLoader() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        queue_.clear();
+    }
+    queued_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+void SceneLoader::feed(const char* data, size_t size) {
+    parser_.feed(data, size);
+    // Whatever this chunk completed goes to the workers now rather than
+    // waiting for a full batch, so a slow writer still shows progress
+    submit();
+}
+
+void SceneLoader::collect(std::string_view id, std::string_view target, bool is_edge,
+                          const DrawAttributes& draw) {
+    if (!pending_) {
+        pending_ = std::make_unique<Batch>();
+    }
+    Batch::Element element;
+    element.is_edge = is_edge;
+    element.id = pending_->store(id);
+    element.target = pending_->store(target);
+    for (size_t slot = 0; slot < DrawAttributes::SLOT_COUNT; slot++) {
+        element.values[slot] = pending_->store(draw.values[slot]);
+    }
+    pending_->elements.push_back(element);
+    
+    if (pending_->elements.size() >= DECODE_BLOCK_SIZE) {
+        submit();
+    }
+}
+
+void SceneLoader::submit() {
+    if (!pending_) {
+        return;
+    }
+    pending_->sequence = next_sequence_++;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back(std::move(pending_));
+    }
+    queued_.notify_one();
+}
+
+void SceneLoader::work() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        queued_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+        if (stopping_) {
+            return;
         }
+        std::unique_ptr<Batch> batch = std::move(queue_.front());
+        queue_.pop_front();
         
-        // Parse edge label drawing commands
-        if (!edge_ldraw.empty()) {
-            auto shapes = parse_xdot_attr(edge_ldraw);
-            edge_shapes.insert(edge_shapes.end(), shapes.begin(), shapes.end());
+        lock.unlock();
+        std::exception_ptr error;
+        try {
+            decode(*batch);
+        } catch (...) {
+            error = std::current_exception();
         }
+        lock.lock();
         
-        if (!edge_shapes.empty()) {
-            auto graph_edge = std::make_shared<GraphEdge>(edge->source, edge->target, edge_shapes);
-            
-            // Set URL if present
-            std::string url = get_attribute_value(edge->attributes, "URL");
-            if (!url.empty()) {
-                graph_edge->set_url(url);
-            }
-            
-            graph_element->add_edge(graph_edge);
+        if (error && !error_) {
+            error_ = error;
         }
+        // Queued even if it failed, so finish() does not wait for it
+        size_t sequence = batch->sequence;
+        done_.emplace(sequence, std::move(batch));
+        decoded_.notify_all();
     }
-    
-    return graph_element;
 }
 
-std::vector<std::shared_ptr<Shape>> XDotParser::parse_xdot_attr(const std::string& xdot_data) {
-    XDotAttrParser parser(xdot_data);
-    return parser.parse();
+void SceneLoader::decode(Batch& batch) const {
+    const GraphElement& graph = *graph_element_;
+    batch.list = std::make_shared<DisplayList>(graph.pens(), graph.prototypes());
+    for (const auto& element : batch.elements) {
+        DrawAttributes draw;
+        for (size_t slot = 0; slot < DrawAttributes::SLOT_COUNT; slot++) {
+            draw.values[slot] = batch.view(element.values[slot]);
+        }
+        if (element.is_edge) {
+            if (auto edge = make_edge(batch.view(element.id), batch.view(element.target), draw, graph,
+                                      batch.list)) {
+                batch.edges.push_back(std::move(edge));
+            }
+        } else if (auto node = make_node(batch.view(element.id), draw, graph, batch.list)) {
+            batch.nodes.push_back(std::move(node));
+        }
+    }
+    batch.list->shrink_to_fit();
+    // The statements are no longer needed
+    batch.text = std::string();
+    batch.elements = std::vector<Batch::Element>();
 }
 
-std::string XDotParser::get_attribute_value(const dot::AttributeList& attrs, 
-                                           const std::string& name, 
-                                           const std::string& default_value) {
-    for (const auto& attr : attrs) {
-        if (attr.name == name) {
-            return attr.value;
+size_t SceneLoader::publish() {
+    std::vector<std::unique_ptr<Batch>> ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (error_) {
+            std::rethrow_exception(error_);
+        }
+        for (auto it = done_.find(next_publish_); it != done_.end(); it = done_.find(next_publish_)) {
+            ready.push_back(std::move(it->second));
+            done_.erase(it);
+            next_publish_++;
         }
     }
-    return default_value;
+    
+    size_t added = 0;
+    for (auto& batch : ready) {
+        for (auto& node : batch->nodes) {
+            graph_element_->add_node(std::move(node));
+        }
+        for (auto& edge : batch->edges) {
+            graph_element_->add_edge(std::move(edge));
+        }
+        added += batch->nodes.size() + batch->edges.size();
+    }
+    return added;
+}
+
+std::shared_ptr<GraphElement> SceneLoader::finish() {
+    parser_.finish();
+    submit();
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        decoded_.wait(lock, [this] { return next_publish_ + done_.size() == next_sequence_; });
+    }
+    publish();
+    return graph_element_;
 }
 
 } // namespace xdot
-} // namespace xdot_cpp
\ No newline at end of file
+} // namespace xdot_cpp
@@ -0,0 +1,157 @@
+// Equivalence check of parse_arena() against DotParser::parse().
+//
+// Dumps the ArenaGraph the same way as the dot::Graph built from the same
+// document and compares the text, so both must agree on node order,
+// merged attributes, the defaults in effect at each element and subgraph
+// membership. Generated documents interleave node and edge statements
+// with default statements at several nesting depths, mention nodes as
+// edge endpoints before their node statements, and repeat them. Errors
+// must be reported at the same place. Files given on the command line are
+// checked as well.
+//
+// Usage: xdot_arena_ast_check [file.dot ...]
+
+#include "graph_dump.h"
+#include "xdot_cpp/dot/arena_ast.h"
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace xdot_cpp;
+
+namespace {
+
+const int DOCUMENTS = 40;
+const size_t STATEMENTS = 400;
+const size_t NODES = 60;
+const int MAX_DEPTH = 3;
+
+std::string node_name(std::mt19937& rng) {
+    return "n" + std::to_string(rng() % NODES);
+}
+
+void append_statements(std::mt19937& rng, int depth, size_t count, const char* arrow, std::string& text) {
+    const char* colors[] = {"red", "blue", "\"#00ff00\"", "black"};
+    const std::string indent(depth * 2 + 2, ' ');
+    for (size_t i = 0; i < count; i++) {
+        switch (rng() % 12) {
+            case 0:
+                text += indent + "node [shape=box, fontsize=" + std::to_string(rng() % 20 + 8) + "]";
+                break;
+            case 1:
+                // Replaces one default and adds another
+                text += indent + "node [fontsize=9 color=" + colors[rng() % 4] + "]";
+                break;
+            case 2:
+                // Empty, but still a set of defaults
+                text += indent + (rng() % 2 ? "node []" : "edge []");
+                break;
+            case 3:
+                text += indent + "edge [style=dashed, color=" + colors[rng() % 4] + "]";
+                break;
+            case 4:
+                text += indent + (rng() % 2 ? "graph [rank=same]" : "label=\"l" + std::to_string(i) + "\"");
+                break;
+            case 5:
+                if (depth < MAX_DEPTH) {
+                    text += indent + (rng() % 3 ? "subgraph cluster_" + std::to_string(rng() % 8) + " {\n"
+                                                : std::string("subgraph {\n"));
+                    append_statements(rng, depth + 1, rng() % 8, arrow, text);
+                    text += indent + "}";
+                } else {
+                    text += indent + node_name(rng);
+                }
+                break;
+            case 6: {
+                // Two edges sharing a node, which is an endpoint twice
+                std::string middle = node_name(rng);
+                text += indent + node_name(rng) + arrow + middle + "; " + middle + arrow + node_name(rng) +
+                        " [weight=" + std::to_string(rng() % 4) + "]";
+                break;
+            }
+            case 7:
+                // Repeated attributes within one list
+                text += indent + node_name(rng) + " [label=a, color=red, label=b]";
+                break;
+            default:
+                if (rng() % 2) {
+                    text += indent + node_name(rng) + " [label=\"" + std::to_string(i) + "\"]";
+                } else {
+                    text += indent + node_name(rng) + arrow + node_name(rng) + " [color=" + colors[rng() % 4] +
+                            "]";
+                }
+                break;
+        }
+        text += rng() % 2 ? ";\n" : "\n";
+    }
+}
+
+std::string make_document(unsigned seed) {
+    std::mt19937 rng(seed);
+    bool directed = seed % 2 == 0;
+    std::string text = seed % 3 == 0 ? "strict " : "";
+    text += directed ? "digraph \"generated\" {\n" : "graph generated {\n";
+    append_statements(rng, 0, STATEMENTS, directed ? " -> " : " -- ", text);
+    return text + "}\n";
+}
+
+template <typename Parse>
+std::string parse_outcome(Parse parse) {
+    try {
+        return checks::dump_graph(*parse());
+    } catch (const dot::ParseError& error) {
+        return "error " + std::to_string(error.line()) + ":" + std::to_string(error.column()) +
+               " " + error.what();
+    }
+}
+
+int check(const std::string& name, const std::string& text) {
+    const std::string expected = parse_outcome([&] { return dot::DotParser(text).parse(); });
+    if (parse_outcome([&] { return dot::parse_arena(text); }) != expected) {
+        std::fprintf(stderr, "%s: parse_arena() differs from DotParser::parse()\n", name.c_str());
+        return 1;
+    }
+    return 0;
+}
+
+bool read_file(const char* path, std::string& text) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    text = contents.str();
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::vector<std::pair<std::string, std::string>> inputs;
+    for (int seed = 0; seed < DOCUMENTS; seed++) {
+        inputs.emplace_back("generated " + std::to_string(seed), make_document(static_cast<unsigned>(seed)));
+    }
+    std::string broken = make_document(DOCUMENTS);
+    broken.insert(broken.size() - 2, "  a -> ]\n");
+    inputs.emplace_back("generated, malformed", broken);
+    for (int i = 1; i < argc; i++) {
+        std::string text;
+        if (!read_file(argv[i], text)) {
+            std::fprintf(stderr, "%s: cannot read\n", argv[i]);
+            return 2;
+        }
+        inputs.emplace_back(argv[i], text);
+    }
+
+    int failures = 0;
+    for (const auto& input : inputs) {
+        failures += check(input.first, input.second);
+    }
+
+    std::printf("%zu inputs, %d failures\n", inputs.size(), failures);
+    return failures == 0 ? 0 : 1;
+}
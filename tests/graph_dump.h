@@ -0,0 +1,271 @@
+#pragma once
+
+// Text form of a parsed dot::Graph for the consistency checks. Two graphs
+// dump to the same text exactly when they hold the same elements,
+// attributes, defaults and subgraph structure; symbol numbering and where
+// the strings are stored do not matter. An ArenaGraph dumps to the text of
+// the dot::Graph built from the same document.
+
+#include "xdot_cpp/dot/arena_ast.h"
+#include "xdot_cpp/dot/parser.h"
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace xdot_cpp {
+namespace checks {
+
+inline void dump_attributes(const dot::Graph& graph, const dot::AttributeList& attributes,
+                            std::string& out) {
+    out += '[';
+    for (const auto& attr : attributes) {
+        out += graph.symbols.name(attr.name);
+        out += '=';
+        out += attr.value;
+        out += ';';
+    }
+    out += ']';
+}
+
+inline void dump_defaults(const dot::Graph& graph, const dot::AttributeSet& defaults, std::string& out) {
+    if (defaults) {
+        dump_attributes(graph, *defaults, out);
+    } else {
+        out += "-";
+    }
+}
+
+inline void dump_subgraph(const dot::Graph& graph, const dot::Subgraph& subgraph, int depth,
+                          std::string& out) {
+    out.append(depth * 2, ' ');
+    out += "subgraph " + subgraph.id + " ";
+    dump_attributes(graph, subgraph.attributes, out);
+    out += " node ";
+    dump_defaults(graph, subgraph.node_defaults, out);
+    out += " edge ";
+    dump_defaults(graph, subgraph.edge_defaults, out);
+    out += " nodes";
+    for (dot::NodeIndex node : subgraph.nodes) {
+        out += ' ' + std::to_string(node);
+    }
+    out += " edges";
+    for (dot::EdgeIndex edge : subgraph.edges) {
+        out += ' ' + std::to_string(edge);
+    }
+    out += '\n';
+    for (const auto& child : subgraph.subgraphs) {
+        dump_subgraph(graph, *child, depth + 1, out);
+    }
+}
+
+inline std::string dump_graph(const dot::Graph& graph) {
+    std::string out;
+    out += graph.strict ? "strict " : "";
+    out += graph.type == dot::Graph::DIGRAPH ? "digraph " : "graph ";
+    out += graph.id + " ";
+    dump_attributes(graph, graph.attributes, out);
+    out += " node ";
+    dump_defaults(graph, graph.node_defaults, out);
+    out += " edge ";
+    dump_defaults(graph, graph.edge_defaults, out);
+    out += '\n';
+
+    for (const auto& node : graph.nodes) {
+        out += "node " + node->id + " ";
+        dump_attributes(graph, node->attributes, out);
+        out += ' ';
+        dump_defaults(graph, node->defaults, out);
+        out += '\n';
+    }
+    for (const auto& edge : graph.edges) {
+        out += "edge " + graph.nodes[edge->source]->id + " " + graph.nodes[edge->target]->id + " ";
+        dump_attributes(graph, edge->attributes, out);
+        out += ' ';
+        dump_defaults(graph, edge->defaults, out);
+        out += '\n';
+    }
+    for (const auto& subgraph : graph.subgraphs) {
+        dump_subgraph(graph, *subgraph, 0, out);
+    }
+    return out;
+}
+
+// Attributes of an ArenaGraph as AttributeList holds them: one entry per
+// name, in order of first assignment, with the last value
+class MergedAttributes {
+public:
+    void set(std::string_view name, std::string_view value) {
+        for (auto& attr : items_) {
+            if (attr.first == name) {
+                attr.second = value;
+                return;
+            }
+        }
+        items_.emplace_back(name, value);
+    }
+
+    void set(dot::ArenaSpan<dot::ArenaAttribute> attributes) {
+        for (const auto& attr : attributes) {
+            set(attr.name, attr.value);
+        }
+    }
+
+    void dump(std::string& out) const {
+        out += '[';
+        for (const auto& attr : items_) {
+            out.append(attr.first);
+            out += '=';
+            out.append(attr.second);
+            out += ';';
+        }
+        out += ']';
+    }
+
+private:
+    std::vector<std::pair<std::string_view, std::string_view>> items_;
+};
+
+inline void dump_attributes(dot::ArenaSpan<dot::ArenaAttribute> attributes, std::string& out) {
+    MergedAttributes merged;
+    merged.set(attributes);
+    merged.dump(out);
+}
+
+inline void dump_defaults(const dot::ArenaGraph& graph, dot::DefaultSet defaults, std::string& out) {
+    if (defaults != dot::NO_DEFAULTS) {
+        dump_attributes(graph.defaults_of(defaults), out);
+    } else {
+        out += "-";
+    }
+}
+
+// Nodes of an ArenaGraph as dot::Graph has them: one per ID, in order of
+// first mention by a node statement or an edge endpoint
+struct ArenaNodes {
+    struct Node {
+        std::string_view id;
+        MergedAttributes attributes;
+        dot::DefaultSet defaults;
+    };
+
+    std::vector<Node> nodes;
+    std::unordered_map<std::string_view, uint32_t> index;
+    // Per subgraph, the nodes its body mentions, in order
+    std::vector<std::vector<uint32_t>> members;
+
+    // scopes[i] is the subgraph a statement is in, or -1 for the root
+    uint32_t mention(std::string_view id, dot::DefaultSet defaults, int scope) {
+        auto found = index.emplace(id, static_cast<uint32_t>(nodes.size()));
+        if (found.second) {
+            nodes.push_back({id, MergedAttributes(), defaults});
+        }
+        uint32_t node = found.first->second;
+        if (scope >= 0 && std::find(members[scope].begin(), members[scope].end(), node) == members[scope].end()) {
+            members[scope].push_back(node);
+        }
+        return node;
+    }
+};
+
+inline void dump_subgraph(const dot::ArenaGraph& graph, uint32_t index, const ArenaNodes& nodes, int depth,
+                          std::string& out) {
+    const dot::ArenaSubgraph& subgraph = graph.subgraphs[index];
+    out.append(depth * 2, ' ');
+    out += "subgraph ";
+    out.append(subgraph.id);
+    out += " ";
+    dump_attributes(graph.attributes_of(subgraph.scope.attributes), out);
+    out += " node ";
+    dump_defaults(graph, subgraph.scope.node_defaults, out);
+    out += " edge ";
+    dump_defaults(graph, subgraph.scope.edge_defaults, out);
+    out += " nodes";
+    for (uint32_t node : nodes.members[index]) {
+        out += ' ' + std::to_string(node);
+    }
+    out += " edges";
+    for (uint32_t edge : graph.children_of(subgraph.scope.edges)) {
+        out += ' ' + std::to_string(edge);
+    }
+    out += '\n';
+    for (uint32_t child : graph.children_of(subgraph.scope.subgraphs)) {
+        dump_subgraph(graph, child, nodes, depth + 1, out);
+    }
+}
+
+inline std::string dump_graph(const dot::ArenaGraph& graph) {
+    // The subgraph each node and edge statement is in
+    std::vector<int> node_scopes(graph.nodes.size(), -1);
+    std::vector<int> edge_scopes(graph.edges.size(), -1);
+    for (size_t i = 0; i < graph.subgraphs.size(); i++) {
+        for (uint32_t node : graph.children_of(graph.subgraphs[i].scope.nodes)) {
+            node_scopes[node] = static_cast<int>(i);
+        }
+        for (uint32_t edge : graph.children_of(graph.subgraphs[i].scope.edges)) {
+            edge_scopes[edge] = static_cast<int>(i);
+        }
+    }
+
+    // Statements in document order; the two arrays are each in order
+    ArenaNodes nodes;
+    nodes.members.resize(graph.subgraphs.size());
+    size_t next_node = 0;
+    size_t next_edge = 0;
+    while (next_node < graph.nodes.size() || next_edge < graph.edges.size()) {
+        if (next_edge == graph.edges.size() ||
+            (next_node < graph.nodes.size() && graph.nodes[next_node].sequence < graph.edges[next_edge].sequence)) {
+            const dot::ArenaNode& node = graph.nodes[next_node];
+            uint32_t index = nodes.mention(node.id, node.defaults, node_scopes[next_node]);
+            nodes.nodes[index].attributes.set(graph.attributes_of(node.attributes));
+            next_node++;
+        } else {
+            const dot::ArenaEdge& edge = graph.edges[next_edge];
+            nodes.mention(edge.source, edge.node_defaults, edge_scopes[next_edge]);
+            nodes.mention(edge.target, edge.node_defaults, edge_scopes[next_edge]);
+            next_edge++;
+        }
+    }
+
+    std::string out;
+    out += graph.strict ? "strict " : "";
+    out += graph.type == dot::Graph::DIGRAPH ? "digraph " : "graph ";
+    out.append(graph.id);
+    out += " ";
+    dump_attributes(graph.attributes_of(graph.root.attributes), out);
+    out += " node ";
+    dump_defaults(graph, graph.root.node_defaults, out);
+    out += " edge ";
+    dump_defaults(graph, graph.root.edge_defaults, out);
+    out += '\n';
+
+    for (const auto& node : nodes.nodes) {
+        out += "node ";
+        out.append(node.id);
+        out += " ";
+        node.attributes.dump(out);
+        out += ' ';
+        dump_defaults(graph, node.defaults, out);
+        out += '\n';
+    }
+    for (const auto& edge : graph.edges) {
+        out += "edge ";
+        out.append(edge.source);
+        out += " ";
+        out.append(edge.target);
+        out += " ";
+        dump_attributes(graph.attributes_of(edge.attributes), out);
+        out += ' ';
+        dump_defaults(graph, edge.defaults, out);
+        out += '\n';
+    }
+    for (uint32_t subgraph : graph.children_of(graph.root.subgraphs)) {
+        dump_subgraph(graph, subgraph, nodes, 0, out);
+    }
+    return out;
+}
+
+} // namespace checks
+} // namespace xdot_cpp
@@ -0,0 +1,154 @@
+// Equivalence check of parse_parallel() against DotParser::parse().
+//
+// Generates documents large enough for every worker count to get slices
+// of their own, with and without ';' between statements, and with strings,
+// comments and subgraphs that span the lines the input is cut at. The
+// parallel parse must build the same graph as the sequential one and
+// intern the same symbols in the same order. Files given on the command
+// line are checked as well.
+//
+// Usage: xdot_parallel_parser_check [file.dot ...]
+
+#include "graph_dump.h"
+#include "xdot_cpp/dot/parallel_parser.h"
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace xdot_cpp;
+
+namespace {
+
+const size_t WORKER_COUNTS[] = {2, 3, 4, 8};
+
+// Bytes per worker below which parse_parallel() stays sequential is
+// 256 KiB; leave room for eight workers
+const size_t DOCUMENT_SIZE = 3 * 1024 * 1024;
+
+std::string node_name(std::mt19937& rng, size_t nodes) {
+    return "n" + std::to_string(rng() % nodes);
+}
+
+std::string make_document(bool semicolons, unsigned seed) {
+    std::mt19937 rng(seed);
+    const size_t nodes = 20000;
+    const char* separator = semicolons ? ";\n" : "\n";
+    const char* colors[] = {"red", "blue", "\"#00ff00\"", "black"};
+
+    std::string text = "digraph \"generated\" {\n  rankdir=LR";
+    text += separator;
+    for (size_t i = 0; text.size() < DOCUMENT_SIZE; i++) {
+        switch (rng() % 10) {
+            case 0:
+                text += "  node [fontsize=" + std::to_string(rng() % 20 + 8) + ", shape=box]";
+                break;
+            case 1:
+                text += "  edge [style=dashed color=" + std::string(colors[rng() % 4]) + "]";
+                break;
+            case 2:
+                // Spans lines, so some cuts land inside the body
+                text += "  subgraph cluster_" + std::to_string(i) + " {\n    label=\"cluster " +
+                        std::to_string(i) + "\"" + separator + "    " + node_name(rng, nodes) + separator +
+                        "    " + node_name(rng, nodes) + " -> " + node_name(rng, nodes) + "\n  }";
+                break;
+            case 3:
+                // Multi-line strings, with and without a line continuation
+                text += "  " + node_name(rng, nodes) + " [label=\"first line\nsecond { line\\\n continued\"]";
+                break;
+            case 4:
+                text += "  /* comment { spanning\n     two lines } */ " + node_name(rng, nodes) +
+                        " [label=<<b>bold</b><br/>" + std::to_string(i) + ">]";
+                break;
+            case 5:
+                // Attribute names that first appear in different slices
+                text += "  " + node_name(rng, nodes) + " [attr_" + std::to_string(rng() % 64) + "=\"" +
+                        std::to_string(rng() % 8) + "\"]";
+                break;
+            default: {
+                std::string source = node_name(rng, nodes);
+                std::string target = node_name(rng, nodes);
+                text += "  " + source + " -> " + target + " [color=" + colors[rng() % 4] +
+                        ", pos=\"e," + std::to_string(rng() % 10000) + "," + std::to_string(rng() % 10000) +
+                        "\"] // trailing } comment";
+                break;
+            }
+        }
+        text += separator;
+    }
+    return text + "}\n";
+}
+
+// Dump of the graph and of its symbol table, in symbol order
+std::string outcome(const std::shared_ptr<dot::Graph>& graph) {
+    std::string out = checks::dump_graph(*graph) + "symbols";
+    for (dot::Symbol symbol = 0; symbol < graph->symbols.size(); symbol++) {
+        out += ' ';
+        out += graph->symbols.name(symbol);
+    }
+    return out;
+}
+
+template <typename Parse>
+std::string parse_outcome(Parse parse) {
+    try {
+        return outcome(parse());
+    } catch (const dot::ParseError& error) {
+        return "error " + std::to_string(error.line()) + ":" + std::to_string(error.column()) +
+               " " + error.what();
+    }
+}
+
+// Number of worker counts whose result differs
+int check(const std::string& name, const std::string& text) {
+    const std::string expected = parse_outcome([&] { return dot::DotParser(text).parse(); });
+    int failures = 0;
+    for (size_t workers : WORKER_COUNTS) {
+        if (parse_outcome([&] { return dot::parse_parallel(text, workers); }) != expected) {
+            std::fprintf(stderr, "%s: %zu workers differ from DotParser::parse()\n", name.c_str(), workers);
+            failures++;
+        }
+    }
+    return failures;
+}
+
+bool read_file(const char* path, std::string& text) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    text = contents.str();
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::vector<std::pair<std::string, std::string>> inputs;
+    inputs.emplace_back("generated, with ';'", make_document(true, 1));
+    inputs.emplace_back("generated, without ';'", make_document(false, 2));
+    // Malformed near the end: the error comes from the sequential fallback
+    std::string broken = make_document(false, 3);
+    broken.insert(broken.size() - 2, "  a -> ]\n");
+    inputs.emplace_back("generated, malformed", broken);
+    for (int i = 1; i < argc; i++) {
+        std::string text;
+        if (!read_file(argv[i], text)) {
+            std::fprintf(stderr, "%s: cannot read\n", argv[i]);
+            return 2;
+        }
+        inputs.emplace_back(argv[i], text);
+    }
+
+    int failures = 0;
+    for (const auto& input : inputs) {
+        failures += check(input.first, input.second);
+    }
+
+    std::printf("%zu inputs, %d failures\n", inputs.size(), failures);
+    return failures == 0 ? 0 : 1;
+}
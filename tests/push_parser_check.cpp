@@ -0,0 +1,162 @@
+// Chunk-boundary check of DotPushParser.
+//
+// Feeds every input to the push parser split in two at each byte offset,
+// and once a byte at a time, and checks that the result is the graph
+// DotParser::parse() builds from the whole text, or the same error at the
+// same position. Every input is checked with LF and with CRLF line endings.
+// Built-in documents cover strings, comments, HTML labels, line
+// continuations and error positions that the files in tests/ may not.
+//
+// Usage: xdot_push_parser_check [file.dot ...]
+
+#include "graph_dump.h"
+#include "xdot_cpp/dot/push_parser.h"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace xdot_cpp;
+
+namespace {
+
+const char* const BUILTIN_DOCUMENT =
+    "/* leading { comment */ strict digraph \"G \\\"quoted\\\"\" {\n"
+    "  // line comment with a { brace\n"
+    "  # preprocessor line }\n"
+    "  graph [label=\"multi\\\n"
+    "line\", bb=\"0,0,10,10\"];\n"
+    "  node [shape=box] edge [color=red]\n"
+    "  a -> b [label=<<b>html</b> <i>{x}</i>>]\n"
+    "  \"quoted \\\"node\\\"\" -> -1.5; .5 -> b\n"
+    "  subgraph cluster_x { d; e -> f; subgraph { g } }\n"
+    "  subgraph { rank=same; h i }\n"
+    "  k [label=\"crlf\\\r\ncontinued\"]\n"
+    "  ranksep=2.5\n"
+    "  l /* inline */ -> m\n"
+    "}\n";
+
+// Fails on line 4, in a statement the push parser sees on its own
+const char* const BUILTIN_ERROR_DOCUMENT =
+    "digraph {\n"
+    "  a -> b\n"
+    "  c [label=\"two\nlines\"]\n"
+    "  d ] e\n"
+    "}\n";
+
+// What parsing a document produced: its dump, or its error and position
+std::string outcome(const std::shared_ptr<dot::Graph>& graph) {
+    return checks::dump_graph(*graph);
+}
+
+std::string outcome(const dot::ParseError& error) {
+    return "error " + std::to_string(error.line()) + ":" + std::to_string(error.column()) +
+           " " + error.what();
+}
+
+std::string parse_whole(const std::string& text) {
+    try {
+        return outcome(dot::DotParser(text).parse());
+    } catch (const dot::ParseError& error) {
+        return outcome(error);
+    }
+}
+
+// Feeds text in pieces ending at each of cuts, then the rest
+std::string parse_pieces(const std::string& text, const std::vector<size_t>& cuts) {
+    try {
+        dot::DotPushParser parser;
+        size_t begin = 0;
+        for (size_t cut : cuts) {
+            parser.feed(text.data() + begin, cut - begin);
+            begin = cut;
+        }
+        parser.feed(text.data() + begin, text.size() - begin);
+        return outcome(parser.finish());
+    } catch (const dot::ParseError& error) {
+        return outcome(error);
+    }
+}
+
+std::string with_crlf(const std::string& text) {
+    std::string converted;
+    for (size_t i = 0; i < text.size(); i++) {
+        if (text[i] == '\n' && (i == 0 || text[i - 1] != '\r')) {
+            converted += '\r';
+        }
+        converted += text[i];
+    }
+    return converted;
+}
+
+// Number of failed comparisons
+int check(const std::string& name, const std::string& text) {
+    const std::string expected = parse_whole(text);
+    int failures = 0;
+
+    for (size_t cut = 0; cut <= text.size(); cut++) {
+        if (parse_pieces(text, {cut}) != expected) {
+            std::fprintf(stderr, "%s: split at byte %zu differs from DotParser::parse()\n",
+                         name.c_str(), cut);
+            failures++;
+        }
+    }
+
+    std::vector<size_t> bytes;
+    for (size_t cut = 1; cut < text.size(); cut++) {
+        bytes.push_back(cut);
+    }
+    if (parse_pieces(text, bytes) != expected) {
+        std::fprintf(stderr, "%s: byte-at-a-time feed differs from DotParser::parse()\n", name.c_str());
+        failures++;
+    }
+    return failures;
+}
+
+bool read_file(const char* path, std::string& text) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    text = contents.str();
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::vector<std::pair<std::string, std::string>> inputs;
+    inputs.emplace_back("built-in document", BUILTIN_DOCUMENT);
+    inputs.emplace_back("built-in error document", BUILTIN_ERROR_DOCUMENT);
+    for (int i = 1; i < argc; i++) {
+        std::string text;
+        if (!read_file(argv[i], text)) {
+            std::fprintf(stderr, "%s: cannot read\n", argv[i]);
+            return 2;
+        }
+        inputs.emplace_back(argv[i], text);
+    }
+
+    int failures = 0;
+    for (const auto& input : inputs) {
+        failures += check(input.first, input.second);
+        failures += check(input.first + " (CRLF)", with_crlf(input.second));
+    }
+
+    // Both line continuations are removed from the value
+    for (const std::string& text : {std::string(BUILTIN_DOCUMENT), with_crlf(BUILTIN_DOCUMENT)}) {
+        auto graph = dot::DotParser(text).parse();
+        dot::NodeIndex k = graph->find_node("k");
+        if (graph->attributes.get(dot::symbols::LABEL) != "multiline" ||
+            k == dot::NO_NODE || graph->nodes[k]->attribute(dot::symbols::LABEL) != "crlfcontinued") {
+            std::fprintf(stderr, "built-in document: line continuation left in a string\n");
+            failures++;
+        }
+    }
+
+    std::printf("%zu inputs, %d failures\n", inputs.size(), failures);
+    return failures == 0 ? 0 : 1;
+}
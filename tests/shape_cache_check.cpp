@@ -0,0 +1,255 @@
+// Check of the ShapeCache memory budget.
+//
+// Drives a cache directly with copies of one Bezier edge and compares its
+// hit, miss, eviction and byte counters with a least-recently-used model.
+// The lists are flattened after they are handed out, as hit tests and
+// drawing do, so the byte count must include the flattened curves. Then
+// parses a generated graph eagerly and lazily under a small budget, and
+// checks that random hit tests agree while the cache stays within budget
+// and its byte count matches the lists in memory.
+//
+// Usage: xdot_shape_cache_check
+
+#include "xdot_cpp/dot/parser.h"
+#include "xdot_cpp/xdot/graph.h"
+#include "xdot_cpp/xdot/shape_cache.h"
+#include "xdot_cpp/xdot/xdot_parser.h"
+#include <algorithm>
+#include <cstdio>
+#include <list>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace xdot_cpp;
+using namespace xdot_cpp::xdot;
+
+namespace {
+
+// Elements the model cache holds at once
+const size_t CAPACITY = 4;
+const size_t ELEMENTS = 24;
+const int ROUNDS = 3000;
+
+const size_t GRAPH_COLUMNS = 20;
+const double SPACING = 120.0;
+const size_t GRAPH_BUDGET = 16 * 1024;
+const int QUERIES = 3000;
+
+const char* const EDGE_DRAW =
+    "c 7 -#000000 B 10 30 30 50 70 90 10 120 40 150 70 170 10 200 40 230 70 250 10 270 30 "
+    "S 5 -solid C 7 -#000000 P 3 270 30 260 26 262 36 ";
+
+// Flattens the curves of list like a hit test does
+void use(const DisplayList& list) {
+    for (size_t i = 0; i < list.size(); i++) {
+        if (list.op(i) == DrawOp::BEZIER) {
+            list.flattened(i, DisplayList::HIT_FLATNESS);
+        }
+    }
+}
+
+std::string format_stats(const ShapeCache::Stats& stats) {
+    return std::to_string(stats.hits) + " hits, " + std::to_string(stats.misses) + " misses, " +
+           std::to_string(stats.evictions) + " evictions, " + std::to_string(stats.bytes) + " bytes, " +
+           std::to_string(stats.elements) + " elements";
+}
+
+int check_counters() {
+    GraphElement graph;
+    std::vector<std::unique_ptr<DeferredShapes>> elements;
+    for (size_t i = 0; i < ELEMENTS; i++) {
+        auto deferred = std::make_unique<DeferredShapes>();
+        deferred->draw_attributes[0] = EDGE_DRAW;
+        deferred->pens = graph.pens();
+        deferred->prototypes = graph.prototypes();
+        deferred->op_count = static_cast<uint32_t>(
+            XDotAttrParser(EDGE_DRAW).scan_bounds(deferred->bounds, deferred->hit_margin));
+        elements.push_back(std::move(deferred));
+    }
+
+    // Every element decodes to the same list, before and after flattening
+    auto reference = elements[0]->decode();
+    const size_t decoded_bytes = reference->memory_usage();
+    use(*reference);
+    const size_t used_bytes = reference->memory_usage();
+    if (used_bytes <= decoded_bytes) {
+        std::fprintf(stderr, "counters: flattening did not grow the list (%zu bytes)\n", used_bytes);
+        return 1;
+    }
+
+    auto cache = std::make_shared<ShapeCache>(CAPACITY * used_bytes);
+    for (auto& deferred : elements) {
+        deferred->cache = cache;
+    }
+
+    std::mt19937 rng(5);
+    std::list<size_t> model;  // most recently used first
+    ShapeCache::Stats expected;
+    int failures = 0;
+    for (int round = 0; round < ROUNDS && failures < 10; round++) {
+        // Mostly recent elements, so there are hits as well as misses
+        size_t i = rng() % 3 ? rng() % (CAPACITY + 2) : rng() % ELEMENTS;
+        auto it = std::find(model.begin(), model.end(), i);
+        bool hit = it != model.end();
+        if (hit) {
+            model.erase(it);
+            expected.hits++;
+        } else {
+            expected.misses++;
+            if (model.size() == CAPACITY) {
+                model.pop_back();
+                expected.evictions++;
+            }
+        }
+        model.push_front(i);
+        expected.elements = model.size();
+        // A list just decoded has not been flattened yet
+        expected.bytes = hit ? model.size() * used_bytes : (model.size() - 1) * used_bytes + decoded_bytes;
+
+        const DisplayList& list = elements[i]->shapes();
+        const ShapeCache::Stats& stats = cache->stats();
+        if (stats.hits != expected.hits || stats.misses != expected.misses ||
+            stats.evictions != expected.evictions || stats.bytes != expected.bytes ||
+            stats.elements != expected.elements) {
+            std::fprintf(stderr, "counters: round %d has %s, expected %s\n", round, format_stats(stats).c_str(),
+                         format_stats(expected).c_str());
+            failures++;
+        }
+        for (size_t k = 0; k < ELEMENTS; k++) {
+            bool cached = std::find(model.begin(), model.end(), k) != model.end();
+            if (elements[k]->is_decoded() != cached) {
+                std::fprintf(stderr, "counters: round %d, element %zu is %sin memory\n", round, k,
+                             cached ? "not " : "");
+                failures++;
+            }
+        }
+
+        use(list);
+        // Otherwise the next shapes() measures the list again
+        if (round % 2) {
+            cache->update();
+            if (cache->stats().bytes != model.size() * used_bytes) {
+                std::fprintf(stderr, "counters: round %d has %zu bytes after update(), expected %zu\n", round,
+                             cache->stats().bytes, model.size() * used_bytes);
+                failures++;
+            }
+        }
+    }
+    std::printf("counters: %s\n", format_stats(cache->stats()).c_str());
+    return failures;
+}
+
+std::string make_graph() {
+    std::mt19937 rng(9);
+    std::uniform_real_distribution<double> wobble(-20.0, 20.0);
+    auto x_of = [](size_t id) { return static_cast<double>(id % GRAPH_COLUMNS) * SPACING + 30.0; };
+    auto y_of = [](size_t id) { return static_cast<double>(id / GRAPH_COLUMNS) * SPACING + 30.0; };
+    auto point = [](double x, double y) { return " " + std::to_string(x) + " " + std::to_string(y); };
+
+    const size_t nodes = GRAPH_COLUMNS * GRAPH_COLUMNS;
+    std::string text = "digraph G {\n";
+    for (size_t id = 0; id < nodes; id++) {
+        text += "  n" + std::to_string(id) + " [_draw_=\"c 7 -#000000 e" + point(x_of(id), y_of(id)) +
+                " 27 18 \"];\n";
+    }
+    for (size_t id = 0; id + 1 < nodes; id++) {
+        size_t to = (id + 1) % GRAPH_COLUMNS ? id + 1 : id + GRAPH_COLUMNS;
+        if (to >= nodes) {
+            continue;
+        }
+        double x1 = x_of(id), y1 = y_of(id), x2 = x_of(to), y2 = y_of(to);
+        std::string curve = point(x1, y1);
+        for (int i = 1; i <= 9; i++) {
+            double t = i / 9.0;
+            bool end = i == 9;
+            curve += point(x1 + (x2 - x1) * t + (end ? 0 : wobble(rng)), y1 + (y2 - y1) * t + (end ? 0 : wobble(rng)));
+        }
+        text += "  n" + std::to_string(id) + " -> n" + std::to_string(to) + " [_draw_=\"c 7 -#000000 B 10" +
+                curve + " \"];\n";
+    }
+    return text + "}\n";
+}
+
+template <typename Element>
+size_t cached_bytes(const std::vector<std::shared_ptr<Element>>& elements, size_t& count) {
+    size_t bytes = 0;
+    for (const auto& element : elements) {
+        if (element->is_decoded()) {
+            // A hit; the list was measured when the query finished
+            bytes += element->display_list().memory_usage();
+            count++;
+        }
+    }
+    return bytes;
+}
+
+std::string edge_name(const std::shared_ptr<GraphEdge>& edge) {
+    return edge ? edge->source() + "->" + edge->target() : "none";
+}
+
+int check_hit_tests() {
+    const std::string text = make_graph();
+    auto eager = XDotParser(dot::DotParser(text).parse()).parse();
+    XDotParser lazy_parser(dot::DotParser(text).parse());
+    lazy_parser.set_lazy(true);
+    auto lazy = lazy_parser.parse();
+    lazy->set_shape_budget(GRAPH_BUDGET);
+    const ShapeCache& cache = *lazy->shape_cache();
+
+    std::mt19937 rng(13);
+    BoundingBox bounds = eager->bounding_box();
+    std::uniform_real_distribution<double> x(bounds.x1, bounds.x2);
+    std::uniform_real_distribution<double> y(bounds.y1, bounds.y2);
+    std::uniform_real_distribution<double> near(-3.0, 3.0);
+    int failures = 0;
+    size_t hits = 0;
+    for (int query = 0; query < QUERIES && failures < 10; query++) {
+        Point p(x(rng), y(rng));
+        if (query % 2) {
+            // Near a curve, where the flattening decides
+            const auto& edge = eager->edges()[rng() % eager->edges().size()];
+            const DisplayList& list = edge->display_list();
+            const Point* control = list.points(edge->ops().first);
+            size_t k = rng() % list.point_count(edge->ops().first);
+            p = Point(control[k].x + near(rng), control[k].y + near(rng));
+        }
+
+        auto eager_node = eager->find_node_at(p);
+        auto lazy_node = lazy->find_node_at(p);
+        std::string eager_edge = edge_name(eager->find_edge_at(p));
+        std::string lazy_edge = edge_name(lazy->find_edge_at(p));
+        if ((eager_node ? eager_node->id() : "none") != (lazy_node ? lazy_node->id() : "none") ||
+            eager_edge != lazy_edge) {
+            std::fprintf(stderr, "hit tests: query %d at (%g, %g) differs: %s %s, lazily %s %s\n", query, p.x, p.y,
+                         eager_node ? eager_node->id().c_str() : "none", eager_edge.c_str(),
+                         lazy_node ? lazy_node->id().c_str() : "none", lazy_edge.c_str());
+            failures++;
+        }
+        hits += eager_node || eager_edge != "none";
+
+        size_t count = 0;
+        size_t bytes = cached_bytes(lazy->nodes(), count) + cached_bytes(lazy->edges(), count);
+        const ShapeCache::Stats& stats = cache.stats();
+        if (stats.bytes != bytes || stats.elements != count || (stats.bytes > GRAPH_BUDGET && count > 1)) {
+            std::fprintf(stderr, "hit tests: query %d has %s; %zu bytes in %zu lists in memory, budget %zu\n",
+                         query, format_stats(stats).c_str(), bytes, count, GRAPH_BUDGET);
+            failures++;
+        }
+    }
+    if (cache.stats().evictions == 0) {
+        std::fprintf(stderr, "hit tests: the budget never evicted anything\n");
+        failures++;
+    }
+    std::printf("hit tests: %d queries, %zu hits; %s\n", QUERIES, hits, format_stats(cache.stats()).c_str());
+    return failures;
+}
+
+} // namespace
+
+int main() {
+    int failures = check_counters() + check_hit_tests();
+    std::printf("%d failures\n", failures);
+    return failures == 0 ? 0 : 1;
+}